@@ -0,0 +1,101 @@
+#include "EventLog.h"
+
+static const char* const subsystemNames[LOG_SUBSYSTEMS] = { "wifi", "fs", "update", "http" };
+static const char* const levelNames[] = { "error", "warn", "info", "debug" };
+
+EventLog::EventLog() {
+	_next = 0;
+	_echo = NULL;
+	for (uint8_t i = 0; i < LOG_SUBSYSTEMS; i++) _levels[i] = LOG_INFO;
+}
+
+// Single writer (loop and SDK callbacks never preempt each other), readers
+// detect overwritten entries by their sequence number
+void EventLog::add(enumLogSubsystem subsystem, enumLogLevel level, const char* format, uint32_t arg0, uint32_t arg1, const char* str) {
+	if (level > _levels[subsystem]) return;
+	strLogEntry& entry = _entries[_next % EVENTLOG_ENTRIES];
+	entry.time = millis();
+	entry.format = format;
+	entry.arg[0] = arg0;
+	entry.arg[1] = arg1;
+	if (str) strlcpy(entry.str, str, sizeof(entry.str));
+	else entry.str[0] = '\0';
+	entry.subsystem = subsystem;
+	entry.level = level;
+	_next++;
+	if (_echo) {
+		char line[EVENTLOG_LINE_LEN];
+		_echo->write((const uint8_t*)line, formatEntry(entry, line, sizeof(line)));
+	}
+}
+
+void EventLog::setLevel(enumLogSubsystem subsystem, enumLogLevel level) {
+	_levels[subsystem] = level;
+}
+
+uint32_t EventLog::first() const {
+	return (_next > EVENTLOG_ENTRIES) ? _next - EVENTLOG_ENTRIES : 0;
+}
+
+size_t EventLog::format(uint32_t seq, char* buf, size_t size) const {
+	if ((seq < first()) || (seq >= _next)) return 0;
+	return formatEntry(_entries[seq % EVENTLOG_ENTRIES], buf, size);
+}
+
+// "[seconds.millis] subsystem level: message\n", always fits into size
+size_t EventLog::formatEntry(const strLogEntry& entry, char* buf, size_t size) {
+	if (size < 2) return 0;
+	int len = snprintf(buf, size, "[%u.%03u] %s %s: ", entry.time / 1000, entry.time % 1000, subsystemNames[entry.subsystem], levelNames[entry.level]);
+	size_t pos = (len < (int)size) ? len : size - 1;
+	uint8_t arg = 0;
+	for (const char* f = entry.format; *f && (pos < size - 2); f++) {
+		if ((*f != '%') || !f[1]) {
+			buf[pos++] = *f;
+			continue;
+		}
+		f++;
+		const char* insert = NULL;
+		char number[12];
+		switch (*f) {
+		case 'u':
+			snprintf(number, sizeof(number), "%u", (arg < 2) ? entry.arg[arg++] : 0);
+			insert = number;
+			break;
+		case 'd':
+			snprintf(number, sizeof(number), "%d", (arg < 2) ? (int32_t)entry.arg[arg++] : 0);
+			insert = number;
+			break;
+		case 'x':
+			snprintf(number, sizeof(number), "%x", (arg < 2) ? entry.arg[arg++] : 0);
+			insert = number;
+			break;
+		case 's':
+			insert = entry.str;
+			break;
+		default:
+			buf[pos++] = *f;
+		}
+		for (; insert && *insert && (pos < size - 2); insert++) buf[pos++] = *insert;
+	}
+	buf[pos++] = '\n';
+	buf[pos] = '\0';
+	return pos;
+}
+
+const char* EventLog::subsystemName(uint8_t subsystem) {
+	return (subsystem < LOG_SUBSYSTEMS) ? subsystemNames[subsystem] : "";
+}
+
+int EventLog::parseSubsystem(const String& name) {
+	for (uint8_t i = 0; i < LOG_SUBSYSTEMS; i++) {
+		if (name == subsystemNames[i]) return i;
+	}
+	return -1;
+}
+
+int EventLog::parseLevel(const String& name) {
+	for (uint8_t i = 0; i < sizeof(levelNames) / sizeof(levelNames[0]); i++) {
+		if (name == levelNames[i]) return i;
+	}
+	return -1;
+}
@@ -0,0 +1,69 @@
+// EventLog.h
+
+#ifndef _EVENTLOG_h
+#define _EVENTLOG_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define EVENTLOG_ENTRIES 64 // ring size, oldest entries are overwritten
+#define EVENTLOG_STR_LEN 16 // copied string argument, longer ones are cut
+#define EVENTLOG_LINE_LEN 96 // formatted entry
+
+typedef enum {
+	LOG_WIFI,
+	LOG_FS,
+	LOG_UPDATE,
+	LOG_HTTP,
+	LOG_SUBSYSTEMS
+} enumLogSubsystem;
+
+typedef enum {
+	LOG_ERROR,
+	LOG_WARN,
+	LOG_INFO,
+	LOG_DEBUG
+} enumLogLevel;
+
+typedef struct {
+	uint32_t time; // millis()
+	const char* format; // string literal, doubles as message id
+	uint32_t arg[2];
+	char str[EVENTLOG_STR_LEN];
+	uint8_t subsystem;
+	uint8_t level;
+} strLogEntry;
+
+// Binary event log: add() only copies the format pointer and the raw
+// arguments into a ring buffer, text is produced when the log is read.
+// Formats may use %u %d %x for the two numbers (in order) and one %s.
+class EventLog {
+public:
+	EventLog();
+	void add(enumLogSubsystem subsystem, enumLogLevel level, const char* format, uint32_t arg0 = 0, uint32_t arg1 = 0, const char* str = NULL);
+	void setLevel(enumLogSubsystem subsystem, enumLogLevel level);
+	enumLogLevel getLevel(enumLogSubsystem subsystem) const { return (enumLogLevel)_levels[subsystem]; }
+	bool enabled(enumLogSubsystem subsystem, enumLogLevel level) const { return level <= _levels[subsystem]; }
+	void setEcho(Print* out) { _echo = out; } // also print every entry (debug builds)
+
+	uint32_t first() const; // sequence number of the oldest entry still stored
+	uint32_t next() const { return _next; } // sequence number of the next entry
+	size_t format(uint32_t seq, char* buf, size_t size) const; // 0 if seq was overwritten
+
+	static const char* subsystemName(uint8_t subsystem);
+	static int parseSubsystem(const String& name); // -1 if unknown
+	static int parseLevel(const String& name);
+
+private:
+	strLogEntry _entries[EVENTLOG_ENTRIES];
+	volatile uint32_t _next;
+	uint8_t _levels[LOG_SUBSYSTEMS];
+	Print* _echo;
+
+	static size_t formatEntry(const strLogEntry& entry, char* buf, size_t size);
+};
+
+#endif // _EVENTLOG_h
@@ -1,4 +1,11 @@
 #include "FSWebServerLib.h"
+#include <lwip/init.h>
+#include <lwip/tcp.h>
+#if LWIP_VERSION_MAJOR == 1
+#include <lwip/tcp_impl.h>
+#else
+#include <lwip/priv/tcp_priv.h>
+#endif
 
 AsyncFSWebServer ESPHTTPServer(80);
 
@@ -6,23 +13,65 @@ AsyncFSWebServer::AsyncFSWebServer(uint16_t port) : AsyncWebServer(port) {}
 
 void AsyncFSWebServer::s_secondTick(void* arg) {
 	AsyncFSWebServer* self = reinterpret_cast<AsyncFSWebServer*>(arg);
+	self->sampleHeap();
 	if (self->_evs.count() > 0) {
 		self->sendTimeData();
 	}
 }
 
+// Publishes only the fields that changed since the last event (all of them after a client connected)
 void AsyncFSWebServer::sendTimeData() {
-	String data = "{";
-	data += "\"time\":\"" + NTP.getTimeStr() + "\",";
-	data += "\"date\":\"" + NTP.getDateStr() + "\",";
-	data += "\"lastSync\":\"" + NTP.getTimeDateString(NTP.getLastNTPSync()) + "\",";
-	data += "\"uptime\":\"" + NTP.getUptimeString() + "\",";
-	data += "\"lastBoot\":\"" + NTP.getTimeDateString(NTP.getLastBootTime()) + "\"";
-	data += "}\r\n";
-	DEBUGLOG(data.c_str());
-	_evs.send(data.c_str(), "timeDate", 0, 500);
-	DEBUGLOG("%s\r\n", NTP.getTimeDateString().c_str());
-	data = String();
+	//slow clients => skip this tick, the next event carries everything that changed meanwhile
+	if (_evs.avgPacketsWaiting() > SSE_MAX_WAITING) return;
+	static const char* const names[SSE_TIME_FIELDS] = { "time", "date", "lastSync", "uptime", "lastBoot" };
+	char values[SSE_TIME_FIELDS][TIMESTR_LEN];
+	time_t moment = now();
+	formatTime(values[0], moment);
+	formatDate(values[1], moment);
+	formatTimeDate(values[2], NTP.getLastNTPSync());
+	formatUptime(values[3], NTP.getUptime());
+	formatTimeDate(values[4], NTP.getLastBootTime());
+
+	size_t len = 0;
+	_sseBuf[len++] = '{';
+	for (uint8_t i = 0; i < SSE_TIME_FIELDS; i++) {
+		if (!_sseTimeFull && (strcmp(values[i], _sseTimeSent[i]) == 0)) continue;
+		len += snprintf(_sseBuf + len, SSE_BUF_LEN - len, "%s\"%s\":\"%s\"", (len > 1) ? "," : "", names[i], values[i]);
+		strcpy(_sseTimeSent[i], values[i]);
+	}
+	if (len == 1) return; //nothing changed
+	snprintf(_sseBuf + len, SSE_BUF_LEN - len, "}\r\n");
+	_sseTimeFull = false;
+	DEBUGLOG(_sseBuf);
+	_evs.send(_sseBuf, "timeDate", 0, 500);
+}
+
+// Only the latest state is sent, bursts from the update callbacks collapse into one event
+void AsyncFSWebServer::publishUpdateState(const char* state) {
+	strlcpy(_updState, state, sizeof(_updState));
+	_updStatePending = true;
+}
+
+void AsyncFSWebServer::flushEvents() {
+	if (_updStatePending) {
+		_updStatePending = false;
+		_evsUpd.send(_updState, "state", 0, 500);
+	}
+	if (_scanEventPending) {
+		_scanEventPending = false;
+		if (_evs.count() > 0) {
+			PooledBuffer json(SLAB_SMALL_SIZE);
+			printScanJSON(json);
+			_evs.send(json.c_str(), "scan", 0, 500);
+		}
+	}
+	if (_updDataPending) {
+		_updDataPending = false;
+		snprintf(_sseBuf, SSE_BUF_LEN, "{\"serverVer\":\"%s\",\"clientVer\":\"%s\",\"updPoss\":\"%s\"}\r\n",
+			_firmware.serverVersion.c_str(), _firmware.clientVersion.c_str(),
+			(_firmware.updateAvailable && (ESP.getFreeSketchSpace() >= _firmware.updateSize)) ? "ja" : "nein");
+		_evsUpd.send(_sseBuf, "UpdData", 0, 500);
+	}
 }
 
 void AsyncFSWebServer::begin(FS* fs) {
@@ -32,9 +81,15 @@ void AsyncFSWebServer::begin(FS* fs) {
 	}
 	DBG_OUTPUT_PORT.print("\r\n\r\n");
 	DEBUGLOG("START Setup\r\n");
+#ifndef RELEASE
+	_log.setEcho(&DBG_OUTPUT_PORT);
+	for (uint8_t i = 0; i < LOG_SUBSYSTEMS; i++) _log.setLevel((enumLogSubsystem)i, LOG_DEBUG);
+#endif // RELEASE
 	//Init
 	_restartPending = false;
 	_apConfig.APenable = false;
+	//response and upload buffers, allocated once while the heap is still in one piece
+	if (!slabBegin()) _log.add(LOG_HTTP, LOG_WARN, "Slab pools not allocated, using heap");
 #ifndef RELEASE
 	//DBG_OUTPUT_PORT.setDebugOutput(true); //uncomment for general Debugging of ESP
 #endif // RELEASE	
@@ -56,12 +111,18 @@ void AsyncFSWebServer::begin(FS* fs) {
 	}
 	DEBUGLOG("\r\n");
 #endif // RELEASE
+	//Index static assets
+	buildAssetIndex();
 	//Load Config
 	_ConfigFileHandler.begin(_fs);
-	if (!load_config()) { // Try to load configuration from file system
-		defaultConfig(); // Load defaults if any error
+	if (!loadConfigRecord()) {
+		//no valid binary record => import the JSON files once
+		if (!load_config()) { // Try to load configuration from file system
+			defaultConfig(); // Load defaults if any error
+		}
+		loadHTTPAuth();
+		saveConfigRecord();
 	}
-	loadHTTPAuth();
 
 	//Connection LED & AP Mode Input
 	DEBUGLOG("Checking if AP needs to be enabled...\r\n");
@@ -72,11 +133,11 @@ void AsyncFSWebServer::begin(FS* fs) {
 	//check SSID Settings + startAP Flag
 	if (_config.ssid == "") {
 		_apConfig.APenable = true;
-		DEBUGLOG("AP triggered by missing SSID\r\n");
+		_log.add(LOG_WIFI, LOG_INFO, "AP mode: no SSID configured");
 	}
 	if (_config.startAP) {
 		_apConfig.APenable = true;
-		DEBUGLOG("AP triggered by startAP Flag\r\n");
+		_log.add(LOG_WIFI, LOG_INFO, "AP mode: startAP flag set");
 	}
 
 	//NTP Init
@@ -102,6 +163,9 @@ void AsyncFSWebServer::begin(FS* fs) {
 		onStationModeDisconnectedHandler = WiFi.onStationModeDisconnected([this](WiFiEventStationModeDisconnected data) {
 			this->onWiFiDisconnected(data);
 		});
+		onStationModeGotIPHandler = WiFi.onStationModeGotIP([this](WiFiEventStationModeGotIP data) {
+			this->onWiFiGotIP(data);
+		});
 	}
 
 	//Configure WiFi
@@ -194,6 +258,10 @@ bool AsyncFSWebServer::load_config() {
 }
 
 bool AsyncFSWebServer::save_config() {
+	return saveConfigRecord();
+}
+
+bool AsyncFSWebServer::saveConfigJSON() {
 	DEBUGLOG(__PRETTY_FUNCTION__);
 	DEBUGLOG("\r\n");
 	if (!_ConfigFileHandler.loadConfigFile(CONFIG_FILE)) return false;
@@ -218,6 +286,7 @@ bool AsyncFSWebServer::save_config() {
 	okay &= _ConfigFileHandler.setValue("startAP", _config.startAP);
 
 	okay &= _ConfigFileHandler.saveConfigFile();
+	updateAssetIndex("/" CONFIG_FILE);
 
 	return okay;
 }
@@ -225,13 +294,10 @@ bool AsyncFSWebServer::save_config() {
 bool AsyncFSWebServer::save_startAP(bool value) {
 	DEBUGLOG(__PRETTY_FUNCTION__);
 	DEBUGLOG("\r\n");
-	if (!_ConfigFileHandler.loadConfigFile(CONFIG_FILE)) return false;
+	//runs on every AP boot => avoid rewriting an unchanged record
+	if ((_config.startAP == value) && !_configDirty) return true;
 	_config.startAP = value;
-	bool okay = true;
-	okay &= _ConfigFileHandler.setValue("startAP", _config.startAP);
-	okay &= _ConfigFileHandler.saveConfigFile();
-
-	return okay;
+	return saveConfigRecord();
 }
 
 bool AsyncFSWebServer::loadHTTPAuth() {
@@ -254,6 +320,10 @@ bool AsyncFSWebServer::loadHTTPAuth() {
 }
 
 bool AsyncFSWebServer::saveHTTPAuth() {
+	return saveConfigRecord();
+}
+
+bool AsyncFSWebServer::saveHTTPAuthJSON() {
 	DEBUGLOG(__PRETTY_FUNCTION__);
 	DEBUGLOG("\r\n");
 	if (!_ConfigFileHandler.loadConfigFile(SECRET_FILE)) return false;
@@ -262,12 +332,130 @@ bool AsyncFSWebServer::saveHTTPAuth() {
 	okay &= _ConfigFileHandler.setValue("user", static_cast<String>(_httpAuth.wwwUsername));
 	okay &= _ConfigFileHandler.setValue("pass", static_cast<String>(_httpAuth.wwwPassword));
 	okay &= _ConfigFileHandler.saveConfigFile();
+	updateAssetIndex("/" SECRET_FILE);
+
+	return okay;
+}
+
+bool AsyncFSWebServer::readConfigRecord(const char* path, strConfigRecord& rec) {
+	File file = _fs->open(path, "r");
+	if (!file) return false;
+	size_t len = file.read((uint8_t*)&rec, sizeof(rec));
+	file.close();
+	if ((len != sizeof(rec)) || (rec.magic != CONFIG_RECORD_MAGIC) || (rec.version != CONFIG_RECORD_VERSION) || (rec.length != sizeof(rec))) {
+		_log.add(LOG_FS, LOG_WARN, "Config record invalid: %s", 0, 0, path);
+		return false;
+	}
+	if (rec.crc != crc32Update(0, (const uint8_t*)&rec, offsetof(strConfigRecord, crc))) {
+		_log.add(LOG_FS, LOG_WARN, "Config record CRC error: %s", 0, 0, path);
+		return false;
+	}
+	return true;
+}
+
+bool AsyncFSWebServer::loadConfigRecord() {
+	DEBUGLOG(__PRETTY_FUNCTION__);
+	DEBUGLOG("\r\n");
+	strConfigRecord rec;
+	//a complete .tmp is the newest state: saveConfigRecord() was cut off before the rename
+	if (_fs->exists("/" CONFIG_RECORD_FILE ".tmp") && readConfigRecord("/" CONFIG_RECORD_FILE ".tmp", rec)) {
+		_log.add(LOG_FS, LOG_WARN, "Config record restored from temporary file");
+		_fs->remove("/" CONFIG_RECORD_FILE);
+		_fs->rename("/" CONFIG_RECORD_FILE ".tmp", "/" CONFIG_RECORD_FILE);
+	}
+	else if (!readConfigRecord("/" CONFIG_RECORD_FILE, rec)) return false;
+	_config.ssid = rec.ssid;
+	_config.password = rec.password;
+	_config.ip = IPAddress(rec.ip);
+	_config.netmask = IPAddress(rec.netmask);
+	_config.gateway = IPAddress(rec.gateway);
+	_config.dns = IPAddress(rec.dns);
+	_config.dhcp = rec.dhcp;
+	_config.ntpServerName = rec.ntpServerName;
+	_config.updateNTPTimeEvery = rec.updateNTPTimeEvery;
+	_config.timezone = rec.timezone;
+	_config.daylight = rec.daylight;
+	_config.deviceName = rec.deviceName;
+	_config.startAP = rec.startAP;
+	_firmware.server = rec.firmwareServer;
+	_firmware.path = rec.firmwarePath;
+	_httpAuth.auth = rec.auth;
+	_httpAuth.wwwUsername = rec.wwwUsername;
+	_httpAuth.wwwPassword = rec.wwwPassword;
+	if (_config.deviceName == "") _config.deviceName = "ESP8266_Default";
+	DEBUGLOG("Config record loaded.\r\n");
+	return true;
+}
+
+bool AsyncFSWebServer::saveConfigRecord() {
+	DEBUGLOG(__PRETTY_FUNCTION__);
+	DEBUGLOG("\r\n");
+	strConfigRecord rec;
+	memset(&rec, 0, sizeof(rec)); // padding is part of the CRC
+	rec.magic = CONFIG_RECORD_MAGIC;
+	rec.version = CONFIG_RECORD_VERSION;
+	rec.length = sizeof(rec);
+	strlcpy(rec.ssid, _config.ssid.c_str(), sizeof(rec.ssid));
+	strlcpy(rec.password, _config.password.c_str(), sizeof(rec.password));
+	rec.ip = _config.ip;
+	rec.netmask = _config.netmask;
+	rec.gateway = _config.gateway;
+	rec.dns = _config.dns;
+	rec.updateNTPTimeEvery = _config.updateNTPTimeEvery;
+	rec.timezone = _config.timezone;
+	rec.dhcp = _config.dhcp;
+	rec.daylight = _config.daylight;
+	rec.startAP = _config.startAP;
+	rec.auth = _httpAuth.auth;
+	strlcpy(rec.ntpServerName, _config.ntpServerName.c_str(), sizeof(rec.ntpServerName));
+	strlcpy(rec.deviceName, _config.deviceName.c_str(), sizeof(rec.deviceName));
+	strlcpy(rec.wwwUsername, _httpAuth.wwwUsername.c_str(), sizeof(rec.wwwUsername));
+	strlcpy(rec.wwwPassword, _httpAuth.wwwPassword.c_str(), sizeof(rec.wwwPassword));
+	strlcpy(rec.firmwareServer, _firmware.server.c_str(), sizeof(rec.firmwareServer));
+	strlcpy(rec.firmwarePath, _firmware.path.c_str(), sizeof(rec.firmwarePath));
+	rec.crc = crc32Update(0, (const uint8_t*)&rec, offsetof(strConfigRecord, crc));
+	_log.add(LOG_FS, LOG_DEBUG, "Writing config record, dirty 0x%x", _configDirty);
+	//write a temporary file first, a power loss must not leave a half written record
+	File file = _fs->open("/" CONFIG_RECORD_FILE ".tmp", "w");
+	if (!file) return false;
+	bool okay = (file.write((const uint8_t*)&rec, sizeof(rec)) == sizeof(rec));
+	file.close();
+	if (okay) {
+		_fs->remove("/" CONFIG_RECORD_FILE);
+		okay = _fs->rename("/" CONFIG_RECORD_FILE ".tmp", "/" CONFIG_RECORD_FILE);
+	}
+	else _fs->remove("/" CONFIG_RECORD_FILE ".tmp");
+	if (okay) _configDirty = 0;
+	return okay;
+}
+
+// POST handlers only mark their changes, handle() writes them outside the TCP callback
+void AsyncFSWebServer::markConfigDirty(uint8_t what) {
+	if (!_configDirty) _configDirtySince = millis();
+	_configDirty |= what;
+}
+
+bool AsyncFSWebServer::flushConfig() {
+	if (!_configDirty) return true;
+	if (saveConfigRecord()) return true;
+	_configDirtySince = millis(); //retry after the next window
+	return false;
+}
 
+bool AsyncFSWebServer::exportConfigJSON() {
+	bool okay = saveConfigJSON();
+	okay &= saveHTTPAuthJSON();
 	return okay;
 }
 
 void AsyncFSWebServer::handle() {
 	ArduinoOTA.handle();
+	expireAdmissions();
+	flushFirmwareStage();
+	flushEvents();
+	if (_configDirty && (millis() - _configDirtySince >= CONFIG_SAVE_DELAY)) flushConfig();
+	if (_wifiFallbackPending) connectWifiFallback();
+	if (_wifiCachePending) saveWiFiCache();
 }
 
 void AsyncFSWebServer::configureWifiAP() {
@@ -277,7 +465,7 @@ void AsyncFSWebServer::configureWifiAP() {
 	WiFi.disconnect();
 	WiFi.mode(WIFI_AP);
 	String APname = _apConfig.APssid + String(ESP.getChipId());
-	DEBUGLOG("AP Name: %s\r\n", APname);
+	_log.add(LOG_WIFI, LOG_INFO, "AP %s started", 0, 0, APname.c_str());
 	if (_httpAuth.auth) {
 		WiFi.softAP(APname.c_str(), _httpAuth.wwwPassword.c_str());
 		DEBUGLOG("AP Pass enabled: %s\r\n", _httpAuth.wwwPassword.c_str());
@@ -299,16 +487,83 @@ void AsyncFSWebServer::configureWifiAP() {
 void AsyncFSWebServer::configureWifi() {
 	DEBUGLOG(__PRETTY_FUNCTION__);
 	DEBUGLOG("\r\n");
-	WiFi.disconnect();
+	WiFi.persistent(false); // settings come from the config record, don't rewrite the SDK sector
 	WiFi.mode(WIFI_STA);
-	DEBUGLOG("Connecting to %s\r\n", _config.ssid.c_str());
-	WiFi.begin(_config.ssid.c_str(), _config.password.c_str());
+	_wifiConnectStart = millis();
+	_wifiConnectTime = 0;
+	_log.add(LOG_WIFI, LOG_INFO, "Connecting to %s", 0, 0, _config.ssid.c_str());
+	if (loadWiFiCache()) {
+		//fast path: no channel scan and, if the lease is still fresh, no DHCP
+		_wifiFast = true;
+		_wifiFastLease = _config.dhcp && _wifiCache.leaseUses && _wifiCache.ip;
+		_log.add(LOG_WIFI, LOG_DEBUG, "Directed connect, channel %u, cached lease %u", _wifiCache.channel, _wifiFastLease);
+		WiFi.begin(_config.ssid.c_str(), _config.password.c_str(), _wifiCache.channel, _wifiCache.bssid);
+		if (_wifiFastLease) {
+			WiFi.config(IPAddress(_wifiCache.ip), IPAddress(_wifiCache.gateway), IPAddress(_wifiCache.netmask), IPAddress(_wifiCache.dns));
+		}
+		_wifiFastTk.once(WIFI_FAST_TIMEOUT, &AsyncFSWebServer::s_wifiFastTimeout, static_cast<void*>(this));
+	}
+	else {
+		WiFi.disconnect();
+		WiFi.begin(_config.ssid.c_str(), _config.password.c_str());
+	}
 	if (!_config.dhcp) {
 		DEBUGLOG("NO DHCP\r\n");
 		WiFi.config(_config.ip, _config.gateway, _config.netmask, _config.dns);
 	}
 }
 
+void AsyncFSWebServer::s_wifiFastTimeout(void* arg) {
+	AsyncFSWebServer* self = reinterpret_cast<AsyncFSWebServer*>(arg);
+	if (self->_wifiFast) self->_wifiFallbackPending = true;
+}
+
+// directed connect failed => forget the cached data, scan and ask DHCP
+void AsyncFSWebServer::connectWifiFallback() {
+	_wifiFallbackPending = false;
+	if (!_wifiFast) return; //got an IP meanwhile
+	_log.add(LOG_WIFI, LOG_WARN, "Directed connect failed, scanning");
+	_wifiFast = false;
+	_fs->remove("/" WIFI_CACHE_FILE);
+	WiFi.disconnect();
+	if (_wifiFastLease) WiFi.config(IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0)); // back to DHCP
+	_wifiFastLease = false;
+	WiFi.begin(_config.ssid.c_str(), _config.password.c_str());
+}
+
+// identifies the network the cache belongs to, a changed ssid or password invalidates it
+uint32_t AsyncFSWebServer::wifiNetId() {
+	uint32_t crc = crc32Update(0, (const uint8_t*)_config.ssid.c_str(), _config.ssid.length());
+	return crc32Update(crc, (const uint8_t*)_config.password.c_str(), _config.password.length());
+}
+
+bool AsyncFSWebServer::loadWiFiCache() {
+	File file = _fs->open("/" WIFI_CACHE_FILE, "r");
+	if (!file) return false;
+	size_t len = file.read((uint8_t*)&_wifiCache, sizeof(_wifiCache));
+	file.close();
+	if ((len != sizeof(_wifiCache)) || (_wifiCache.magic != WIFI_CACHE_MAGIC) || (_wifiCache.netId != wifiNetId())
+		|| (_wifiCache.crc != crc32Update(0, (const uint8_t*)&_wifiCache, offsetof(strWiFiCache, crc)))) {
+		memset(&_wifiCache, 0, sizeof(_wifiCache));
+		return false;
+	}
+	return true;
+}
+
+bool AsyncFSWebServer::saveWiFiCache() {
+	_wifiCachePending = false;
+	_wifiCache.crc = crc32Update(0, (const uint8_t*)&_wifiCache, offsetof(strWiFiCache, crc));
+	File file = _fs->open("/" WIFI_CACHE_FILE, "w");
+	if (!file) return false;
+	bool okay = (file.write((const uint8_t*)&_wifiCache, sizeof(_wifiCache)) == sizeof(_wifiCache));
+	file.close();
+	return okay;
+}
+
+uint32_t AsyncFSWebServer::getWiFiConnectTime() {
+	return _wifiConnectTime;
+}
+
 void AsyncFSWebServer::configureOTA(String password) {
 	DEBUGLOG(__PRETTY_FUNCTION__);
 	DEBUGLOG("\r\n");
@@ -356,6 +611,36 @@ void AsyncFSWebServer::onWiFiConnected(WiFiEventStationModeConnected data) {
 	_wifiWasConnected = true;
 }
 
+void AsyncFSWebServer::onWiFiGotIP(WiFiEventStationModeGotIP data) {
+	if (!_wifiConnectTime) {
+		_wifiConnectTime = millis() - _wifiConnectStart;
+		_log.add(LOG_WIFI, LOG_INFO, "Got IP after %u ms (%s)", _wifiConnectTime, 0, _wifiFast ? "directed" : "scan");
+	}
+	_wifiFastTk.detach();
+	//remember how we got here, written by handle() if anything changed
+	strWiFiCache cache;
+	memset(&cache, 0, sizeof(cache));
+	cache.magic = WIFI_CACHE_MAGIC;
+	cache.netId = wifiNetId();
+	memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+	cache.channel = WiFi.channel();
+	if (_config.dhcp) {
+		//a reconnect with the cached lease still configured doesn't count as boot
+		if (_wifiFastLease) cache.leaseUses = _wifiFast ? _wifiCache.leaseUses - 1 : _wifiCache.leaseUses;
+		else cache.leaseUses = WIFI_LEASE_USES;
+		cache.ip = data.ip;
+		cache.gateway = data.gw;
+		cache.netmask = data.mask;
+		cache.dns = WiFi.dnsIP();
+	}
+	_wifiFast = false;
+	cache.crc = _wifiCache.crc;
+	if (memcmp(&cache, &_wifiCache, sizeof(cache)) != 0) {
+		_wifiCache = cache;
+		_wifiCachePending = true;
+	}
+}
+
 void AsyncFSWebServer::onWiFiDisconnected(WiFiEventStationModeDisconnected data) {
 	DEBUGLOG("\r\ncase STA_DISCONNECTED\r\n");
 	if (CONNECTION_LED >= 0) {
@@ -365,10 +650,10 @@ void AsyncFSWebServer::onWiFiDisconnected(WiFiEventStationModeDisconnected data)
 		wifiDisconnectedSince = millis();
 	}
 	int disconSince = (int)((millis() - wifiDisconnectedSince) / 1000);
-	DEBUGLOG("Disconnected since %d seconds\r\n", disconSince);
+	_log.add(LOG_WIFI, LOG_WARN, "Disconnected (reason %u) since %u s", data.reason, disconSince);
 	//Start in AP Mode after 30 Seconds if Wifi was not connected
 	if ((disconSince >= 30) && !_restartPending && !_wifiWasConnected) {
-		DEBUGLOG("Wifi connect timeout... starting AP\r\n");
+		_log.add(LOG_WIFI, LOG_ERROR, "Connect timeout, restarting as AP");
 		this->save_startAP(true);
 		restart();
 	}
@@ -399,73 +684,363 @@ void AsyncFSWebServer::handleFileList(AsyncWebServerRequest *request) {
 	Dir dir = _fs->openDir(path);
 	path = String();
 
-	String output = "[";
+	//walk the directory lazily, one entry per refill of the TCP window
+	bool first = true;
+	bool done = false;
+	char entry[96] = "[";
+	size_t entryLen = 1;
+	size_t entryPos = 0;
+	AsyncWebServerResponse *response = request->beginChunkedResponse("text/json", [dir, first, done, entry, entryLen, entryPos](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+		size_t written = 0;
+		while (written < maxLen) {
+			//copy (rest of) the rendered entry
+			if (entryPos < entryLen) {
+				size_t n = entryLen - entryPos;
+				if (n > maxLen - written) n = maxLen - written;
+				memcpy(buffer + written, entry + entryPos, n);
+				written += n;
+				entryPos += n;
+				continue;
+			}
+			if (done) break;
+			entryPos = 0;
+			if (dir.next()) {
+				int n = snprintf(entry, sizeof(entry), "%s{\"type\":\"file\",\"name\":\"%s\",\"size\":%u"
+#ifdef FILELIST_MTIME
+					",\"mtime\":%u"
+#endif
+					"}", first ? "" : ",", dir.fileName().c_str() + 1, dir.fileSize()
+#ifdef FILELIST_MTIME
+					, (uint32_t)dir.fileTime()
+#endif
+				);
+				entryLen = (n < (int)sizeof(entry)) ? n : sizeof(entry) - 1;
+				first = false;
+			}
+			else {
+				entry[0] = ']';
+				entryLen = 1;
+				done = true;
+			}
+		}
+		return written;
+	});
+	sendResponse(request, response);
+}
+
+// Packs up to 8 characters of a lower case extension into one integer so
+// the built-in table can be a plain switch (resolved by the compiler)
+static constexpr uint64_t mimeKey(const char* ext, uint8_t i = 0) {
+	return (ext[i] == '\0' || i == 8) ? 0 : ((uint64_t)(uint8_t)ext[i] << (8 * i)) | mimeKey(ext, i + 1);
+}
+
+static const char* builtinContentType(uint64_t key) {
+	switch (key) {
+	case mimeKey("htm"): return "text/html";
+	case mimeKey("html"): return "text/html";
+	case mimeKey("css"): return "text/css";
+	case mimeKey("js"): return "application/javascript";
+	case mimeKey("json"): return "application/json";
+	case mimeKey("png"): return "image/png";
+	case mimeKey("gif"): return "image/gif";
+	case mimeKey("jpg"): return "image/jpeg";
+	case mimeKey("jpeg"): return "image/jpeg";
+	case mimeKey("ico"): return "image/x-icon";
+	case mimeKey("svg"): return "image/svg+xml";
+	case mimeKey("xml"): return "text/xml";
+	case mimeKey("pdf"): return "application/x-pdf";
+	case mimeKey("zip"): return "application/x-zip";
+	case mimeKey("gz"): return "application/x-gzip";
+	case mimeKey("woff"): return "font/woff";
+	case mimeKey("woff2"): return "font/woff2";
+	case mimeKey("ttf"): return "font/ttf";
+	case mimeKey("wasm"): return "application/wasm";
+	case mimeKey("csv"): return "text/csv";
+	default: return NULL;
+	}
+}
+
+// lower case key of the extension after the last '.', 0 if there is none
+static uint64_t extensionKey(const char* filename, size_t len) {
+	size_t dot = len;
+	while (dot > 0 && filename[dot - 1] != '.' && filename[dot - 1] != '/') dot--;
+	if (dot == 0 || filename[dot - 1] != '.') return 0;
+	uint64_t key = 0;
+	for (uint8_t i = 0; (dot + i < len) && (i < 8); i++) {
+		key |= (uint64_t)(uint8_t)tolower(filename[dot + i]) << (8 * i);
+	}
+	return key;
+}
+
+const char* AsyncFSWebServer::findContentType(const char* filename, size_t len) const {
+	uint64_t key = extensionKey(filename, len);
+	if (!key) return NULL;
+	for (size_t i = 0; i < _mimeTypes.size(); i++) {
+		if (_mimeTypes[i].key == key) return _mimeTypes[i].type;
+	}
+	return builtinContentType(key);
+}
+
+const char* AsyncFSWebServer::getContentType(const String& filename) const {
+	const char* type = findContentType(filename.c_str(), filename.length());
+	return type ? type : "text/plain";
+}
+
+void AsyncFSWebServer::addContentType(const char* extension, const char* contentType) {
+	if (*extension == '.') extension++;
+	uint64_t key = 0;
+	for (uint8_t i = 0; extension[i] && (i < 8); i++) {
+		key |= (uint64_t)(uint8_t)tolower(extension[i]) << (8 * i);
+	}
+	if (!key) return;
+	size_t i = 0;
+	while (i < _mimeTypes.size() && _mimeTypes[i].key != key) i++;
+	if (i < _mimeTypes.size()) {
+		_mimeTypes[i].type = contentType;
+	}
+	else {
+		strMimeType mime;
+		mime.key = key;
+		mime.type = contentType;
+		_mimeTypes.push_back(mime);
+	}
+	//entries already indexed may resolve differently now
+	for (i = 0; i < _assetIndex.size(); i++) {
+		_assetIndex[i].contentType = getContentType(String(_assetIndex[i].path));
+	}
+}
+
+static bool assetOrder(const strAssetEntry& a, const strAssetEntry& b) {
+	return strcmp(a.path, b.path) < 0;
+}
+
+static bool assetBefore(const strAssetEntry& a, const char* path) {
+	return strcmp(a.path, path) < 0;
+}
+
+// only files a page pulls in (known content type, also as .gz), so e.g. log files do not take memory
+bool AsyncFSWebServer::isIndexable(const String& path) const {
+	size_t len = path.endsWith(".gz") ? path.length() - 3 : path.length();
+	return (len < ASSET_PATH_LEN) && findContentType(path.c_str(), len);
+}
+
+// Fixed size entries, counted first so the storage is reserved once
+void AsyncFSWebServer::buildAssetIndex() {
+	DEBUGLOG(__FUNCTION__);
+	DEBUGLOG("\r\n");
+	size_t count = 0;
+	Dir dir = _fs->openDir("/");
 	while (dir.next()) {
-		File entry = dir.openFile("r");
-		if (output != "[")
-			output += ',';
-		bool isDir = false;
-		output += "{\"type\":\"";
-		output += (isDir) ? "dir" : "file";
-		output += "\",\"name\":\"";
-		output += String(entry.name()).substring(1);
-		output += "\"}";
-		entry.close();
-	}
-
-	output += "]";
-	DEBUGLOG("%s\r\n", output.c_str());
-	request->send(200, "text/json", output);
-}
-
-String getContentType(String filename, AsyncWebServerRequest *request) {
-	if (request->hasArg("download")) return "application/octet-stream";
-	else if (filename.endsWith(".htm")) return "text/html";
-	else if (filename.endsWith(".html")) return "text/html";
-	else if (filename.endsWith(".css")) return "text/css";
-	else if (filename.endsWith(".js")) return "application/javascript";
-	else if (filename.endsWith(".json")) return "application/json";
-	else if (filename.endsWith(".png")) return "image/png";
-	else if (filename.endsWith(".gif")) return "image/gif";
-	else if (filename.endsWith(".jpg")) return "image/jpeg";
-	else if (filename.endsWith(".ico")) return "image/x-icon";
-	else if (filename.endsWith(".xml")) return "text/xml";
-	else if (filename.endsWith(".pdf")) return "application/x-pdf";
-	else if (filename.endsWith(".zip")) return "application/x-zip";
-	else if (filename.endsWith(".gz")) return "application/x-gzip";
-	return "text/plain";
+		if (isIndexable(dir.fileName())) count++;
+	}
+	if (count > ASSET_INDEX_MAX) count = ASSET_INDEX_MAX;
+	std::vector<strAssetEntry>().swap(_assetIndex);
+	_assetIndex.reserve(count);
+	dir = _fs->openDir("/");
+	while ((_assetIndex.size() < count) && dir.next()) {
+		String name = dir.fileName();
+		if (!isIndexable(name)) continue;
+		strAssetEntry entry;
+		entry.gz = name.endsWith(".gz");
+		if (entry.gz) name.remove(name.length() - 3);
+		strlcpy(entry.path, name.c_str(), sizeof(entry.path));
+		entry.size = dir.fileSize();
+#ifdef FILELIST_MTIME
+		entry.mtime = dir.fileTime();
+#else
+		entry.mtime = 0;
+#endif
+		entry.contentType = getContentType(name);
+		_assetIndex.push_back(entry);
+	}
+	std::sort(_assetIndex.begin(), _assetIndex.end(), assetOrder);
+	//merge a file and its .gz variant, the .gz file is served
+	size_t merged = 0;
+	for (size_t i = 0; i < _assetIndex.size(); i++) {
+		if (merged && (strcmp(_assetIndex[merged - 1].path, _assetIndex[i].path) == 0)) {
+			if (_assetIndex[i].gz) _assetIndex[merged - 1] = _assetIndex[i];
+		}
+		else _assetIndex[merged++] = _assetIndex[i];
+	}
+	_assetIndex.resize(merged);
+	DEBUGLOG("Asset index: %u entries\r\n", _assetIndex.size());
+}
+
+strAssetEntry* AsyncFSWebServer::findAsset(const String& path) {
+	std::vector<strAssetEntry>::iterator it = std::lower_bound(_assetIndex.begin(), _assetIndex.end(), path.c_str(), assetBefore);
+	if (it == _assetIndex.end() || strcmp(it->path, path.c_str()) != 0) return NULL;
+	return &(*it);
+}
+
+// Reads what is on the filesystem now, false if neither path nor path.gz exists
+bool AsyncFSWebServer::probeAsset(const String& path, strAssetEntry& entry) {
+	String pathWithGz = path + ".gz";
+	entry.gz = _fs->exists(pathWithGz);
+	if (!entry.gz && !_fs->exists(path)) return false;
+	File file = _fs->open(entry.gz ? pathWithGz : path, "r");
+	if (!file) return false;
+	entry.size = file.size();
+#ifdef FILELIST_MTIME
+	entry.mtime = file.getLastWrite();
+#else
+	entry.mtime = 0;
+#endif
+	file.close();
+	strlcpy(entry.path, path.c_str(), sizeof(entry.path));
+	entry.contentType = getContentType(path);
+	return true;
+}
+
+// Revalidates an entry with one open of the variant it serves, size and mtime
+// change with every write. False if that file is gone.
+bool AsyncFSWebServer::statAsset(const String& path, strAssetEntry& entry) {
+	File file = entry.gz ? _fs->open(path + ".gz", "r") : _fs->open(path, "r");
+	if (!file) return false;
+	entry.size = file.size();
+#ifdef FILELIST_MTIME
+	entry.mtime = file.getLastWrite();
+#endif
+	file.close();
+	return true;
+}
+
+// Re-probes one path and updates, inserts or removes its entry. The result
+// goes to probed (also for paths that are not indexed), returns false if the
+// path cannot be served.
+bool AsyncFSWebServer::refreshAsset(const String& path, strAssetEntry& probed) {
+	bool found = probeAsset(path, probed);
+	strAssetEntry* entry = findAsset(path);
+	if (!found) {
+		if (entry) _assetIndex.erase(_assetIndex.begin() + (entry - &_assetIndex[0]));
+		return false;
+	}
+	if (entry) {
+		*entry = probed;
+	}
+	else if (isIndexable(path) && !path.endsWith(".gz") && (_assetIndex.size() < ASSET_INDEX_MAX)) {
+		//grow in small steps, doubling would overshoot the budget
+		if (_assetIndex.size() == _assetIndex.capacity()) _assetIndex.reserve(std::min(_assetIndex.size() + 4, (size_t)ASSET_INDEX_MAX));
+		std::vector<strAssetEntry>::iterator it = std::lower_bound(_assetIndex.begin(), _assetIndex.end(), probed.path, assetBefore);
+		_assetIndex.insert(it, probed);
+	}
+	return true;
+}
+
+// Built from persistent metadata only, so browser caches survive a restart
+void AsyncFSWebServer::formatETag(const strAssetEntry& entry, char* buf, size_t size) {
+	snprintf(buf, size, "\"%x-%x%s\"", entry.mtime, entry.size, entry.gz ? "-gz" : "");
+}
+
+void AsyncFSWebServer::updateAssetIndex(const String& path) {
+	//a changed .gz file changes what is served for its base path
+	String basePath = path.endsWith(".gz") ? path.substring(0, path.length() - 3) : path;
+	if (!findAsset(basePath) && !isIndexable(basePath)) return;
+	strAssetEntry probed;
+	refreshAsset(basePath, probed);
+}
+
+void AsyncFSWebServer::setCacheControl(const String& pathPrefix, uint32_t maxAge) {
+	for (size_t i = 0; i < _cachePolicies.size(); i++) {
+		if (_cachePolicies[i].prefix == pathPrefix) {
+			_cachePolicies[i].maxAge = maxAge;
+			return;
+		}
+	}
+	strCachePolicy policy;
+	policy.prefix = pathPrefix;
+	policy.maxAge = maxAge;
+	_cachePolicies.push_back(policy);
+}
+
+void AsyncFSWebServer::setGzipUploads(bool enable) {
+	_gzipUploads = enable;
+}
+
+void AsyncFSWebServer::setMaxRequests(uint8_t maxRequests) {
+	//at least one slot for normal requests
+	_maxRequests = (maxRequests > ADMISSION_RESERVED) ? maxRequests : ADMISSION_RESERVED + 1;
+}
+
+uint32_t AsyncFSWebServer::getCacheMaxAge(const String& path) {
+	uint32_t maxAge = 0;
+	size_t bestLength = 0;
+	for (size_t i = 0; i < _cachePolicies.size(); i++) {
+		const String& prefix = _cachePolicies[i].prefix;
+		if ((prefix.length() >= bestLength) && path.startsWith(prefix)) {
+			bestLength = prefix.length();
+			maxAge = _cachePolicies[i].maxAge;
+		}
+	}
+	return maxAge;
 }
 
 bool AsyncFSWebServer::handleFileRead(String path, AsyncWebServerRequest *request) {
 	DEBUGLOG("handleFileRead: %s\r\n", path.c_str());
 	if (path.endsWith("/"))
 		path += "index.html";
-	String contentType = getContentType(path, request);
-	String pathWithGz = path + ".gz";
-	if (_fs->exists(pathWithGz) || _fs->exists(path)) {
-		if (_fs->exists(pathWithGz)) {
-			path += ".gz";
+	//a revalidation must match what is on the filesystem now, the sketch or
+	//JSONtoSPIFFS may have changed the file behind the index
+	AsyncWebHeader* ifNoneMatch = request->getHeader("If-None-Match");
+	strAssetEntry probed;
+	strAssetEntry* asset = findAsset(path);
+	if (asset && ifNoneMatch && !statAsset(path, *asset)) asset = NULL;
+	//not indexed, or the served variant is gone => full probe
+	if (!asset) {
+		if (!refreshAsset(path, probed)) {
+			DEBUGLOG("Cannot find %s\n", path.c_str());
+			return false;
 		}
-		DEBUGLOG("Content type: %s\r\n", contentType.c_str());
-		AsyncWebServerResponse *response = request->beginResponse(*_fs, path, contentType);
-		if (path.endsWith(".gz"))
-			response->addHeader("Content-Encoding", "gzip");
-		//File file = SPIFFS.open(path, "r");
-		DEBUGLOG("File %s exist\r\n", path.c_str());
-		request->send(response);
-		DEBUGLOG("File %s Sent\r\n", path.c_str());
-
+		asset = &probed;
+	}
+	_metricsFileRequests++;
+	char etag[ASSET_ETAG_LEN];
+	formatETag(*asset, etag, sizeof(etag));
+	//browser copy still valid => answer without body
+	char cacheControl[24];
+	uint32_t maxAge = getCacheMaxAge(path);
+	if (maxAge) snprintf(cacheControl, sizeof(cacheControl), "max-age=%u", maxAge);
+	else strcpy(cacheControl, "no-cache");
+	if (ifNoneMatch && strstr(ifNoneMatch->value().c_str(), etag)) {
+		DEBUGLOG("File %s not modified\r\n", path.c_str());
+		_metricsFileNotModified++;
+		AsyncWebServerResponse *response = request->beginResponse(304);
+		response->addHeader("ETag", etag);
+		response->addHeader("Cache-Control", cacheControl);
+		sendResponse(request, response);
 		return true;
 	}
-	else {
-		DEBUGLOG("Cannot find %s\n", path.c_str());
+	const char* contentType = request->hasArg("download") ? "application/octet-stream" : asset->contentType;
+	bool gz = asset->gz;
+	uint32_t size = asset->size;
+	if (gz) {
+		path += ".gz";
+	}
+	DEBUGLOG("Content type: %s\r\n", contentType);
+	AsyncWebServerResponse *response = request->beginResponse(*_fs, path, contentType);
+	if (!response->_sourceValid()) {
+		//index was stale (file removed behind our back)
+		delete response;
+		DEBUGLOG("Cannot open %s\n", path.c_str());
+		if (gz) path.remove(path.length() - 3);
+		refreshAsset(path, probed);
 		return false;
 	}
+	if (gz)
+		response->addHeader("Content-Encoding", "gzip");
+	response->addHeader("ETag", etag);
+	response->addHeader("Cache-Control", cacheControl);
+	DEBUGLOG("File %s exist\r\n", path.c_str());
+	_metricsFileBytes += size;
+	//every asset costs its own connection (the server closes after one response),
+	//so do not let Nagle hold back the last segment of small files
+	request->client()->setNoDelay(true);
+	sendResponse(request, response);
+	DEBUGLOG("File %s Sent\r\n", path.c_str());
+
+	return true;
 }
 
 void AsyncFSWebServer::handleFileCreate(AsyncWebServerRequest *request) {
-	if (!checkAuth(request))
-		return request->requestAuthentication();
 	if (request->args() == 0)
 		return request->send(500, "text/plain", "BAD ARGS");
 	String path = request->arg(0U);
@@ -479,13 +1054,12 @@ void AsyncFSWebServer::handleFileCreate(AsyncWebServerRequest *request) {
 		file.close();
 	else
 		return request->send(500, "text/plain", "CREATE FAILED");
+	updateAssetIndex(path);
 	request->send(200, "text/plain", "");
 	path = "";
 }
 
 void AsyncFSWebServer::handleFileDelete(AsyncWebServerRequest *request) {
-	if (!checkAuth(request))
-		return request->requestAuthentication();
 	if (request->args() == 0) return request->send(500, "text/plain", "BAD ARGS");
 	String path = request->arg(0U);
 	DEBUGLOG("handleFileDelete: %s\r\n", path.c_str());
@@ -494,59 +1068,224 @@ void AsyncFSWebServer::handleFileDelete(AsyncWebServerRequest *request) {
 	if (!_fs->exists(path))
 		return request->send(404, "text/plain", "FileNotFound");
 	_fs->remove(path);
+	updateAssetIndex(path);
 	request->send(200, "text/plain", "");
 	path = "";
 }
 
 void AsyncFSWebServer::handleFileUpload(AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
-	static File fsUploadFile;
-	static size_t fileSize = 0;
-
+	AsyncFSUpload* upload = findUpload(request);
 	if (!index) { // Start
+		if (!upload) {
+			//upload data arrives before the request handler => check auth here
+			//counted by recordRequest() when handleRequest() answers with the challenge
+			if (checkAuth(request) == AUTH_DENIED) return;
+			upload = openUpload(request);
+			if (!upload) {
+				_log.add(LOG_FS, LOG_WARN, "Upload rejected, no free slot");
+				return;
+			}
+		}
 		DEBUGLOG("handleFileUpload Name: %s\r\n", filename.c_str());
 		if (!filename.startsWith("/")) filename = "/" + filename;
-		fsUploadFile = _fs->open(filename, "w");
+		startUploadFile(*upload, filename);
 		DEBUGLOG("First upload part.\r\n");
 	}
+	if (!upload || !upload->file) return;
 	// Continue
-	if (fsUploadFile) {
-		DEBUGLOG("Continue upload part. Size = %u\r\n", len);
-		if (fsUploadFile.write(data, len) != len) {
-			DBG_OUTPUT_PORT.println("Write error during upload");
+	DEBUGLOG("Continue upload part. Size = %u\r\n", len);
+	size_t written = upload->gzWriter ? upload->gzWriter->write(data, len) : upload->write(data, len);
+	if (written != len) {
+		_log.add(LOG_FS, LOG_ERROR, "Write error during upload of %s", 0, 0, upload->file.name());
+		upload->status = 500;
+		finishUploadFile(*upload);
+		return;
+	}
+	upload->size += len;
+	if (final) finishUploadFile(*upload); // End
+}
+
+AsyncFSUpload* AsyncFSWebServer::findUpload(AsyncWebServerRequest *request) {
+	for (uint8_t i = 0; i < UPLOAD_MAX_CONCURRENT; i++) {
+		if (_uploads[i].request == request) return &_uploads[i];
+	}
+	return NULL;
+}
+
+AsyncFSUpload* AsyncFSWebServer::openUpload(AsyncWebServerRequest *request) {
+	AsyncFSUpload* upload = findUpload(NULL);
+	if (!upload || !upload->begin(request)) return NULL;
+	//expireAdmissions() frees the slot if the connection closes before handleUploadDone()
+	return upload;
+}
+
+void AsyncFSWebServer::startUploadFile(AsyncFSUpload& upload, const String& filename) {
+	if (upload.status != 200) return;
+	//SPIFFS cannot preallocate => refuse early if the body cannot fit
+	size_t needed = upload.request->contentLength();
+	FSInfo info;
+	if (needed && _fs->info(info)) {
+		size_t available = info.totalBytes - info.usedBytes;
+		File old = _fs->open(filename, "r");
+		if (old) {
+			available += old.size();
+			old.close();
+		}
+		if (needed > available) {
+			_log.add(LOG_FS, LOG_WARN, "Upload of %u bytes does not fit into %u", needed, available);
+			upload.status = 507;
+			return;
 		}
-		else
-			fileSize += len;
 	}
-	if (final) { // End
-		if (fsUploadFile) {
-			fsUploadFile.close();
+	//"?gzip=0" / "?gzip=1" overrides setGzipUploads() for this upload
+	bool compress = _gzipUploads;
+	if (upload.request->hasParam("gzip")) compress = upload.request->getParam("gzip")->value() != "0";
+	if (compress && isCompressible(filename)) {
+		upload.file = _fs->open(filename + ".gz", "w");
+		if (upload.file) upload.gzWriter = new (std::nothrow) GzipWriter(upload);
+		if (upload.gzWriter) {
+			upload.plainPath = filename;
+		}
+		else if (upload.file) {
+			//not enough heap for the compressor => store the file as it is
+			String gzPath = upload.file.name();
+			upload.file.close();
+			_fs->remove(gzPath);
 		}
-		DEBUGLOG("handleFileUpload Size: %u\n", fileSize);
-		fileSize = 0;
 	}
+	if (!upload.gzWriter) upload.file = _fs->open(filename, "w");
+	if (!upload.file) upload.status = 500;
+}
+
+void AsyncFSWebServer::finishUploadFile(AsyncFSUpload& upload) {
+	if (!upload.file) return;
+	bool okay = (upload.status == 200);
+	if (upload.gzWriter) {
+		okay = upload.gzWriter->finish() && okay;
+		_log.add(LOG_FS, LOG_DEBUG, "Upload compressed %u -> %u", upload.gzWriter->inputSize(), upload.gzWriter->outputSize());
+		delete upload.gzWriter;
+		upload.gzWriter = NULL;
+	}
+	okay = upload.flushBatch() && okay;
+	String path = upload.file.name();
+	upload.file.close();
+	if (!okay) {
+		//never leave a truncated asset behind
+		upload.status = 500;
+		_fs->remove(path);
+	}
+	else if (upload.plainPath.length() && _fs->exists(upload.plainPath)) {
+		//the uncompressed copy would be stale now
+		_fs->remove(upload.plainPath);
+	}
+	if (okay && (path.endsWith(CONFIG_FILE) || path.endsWith(SECRET_FILE))) {
+		//uploaded settings are imported again on the next boot
+		_fs->remove("/" CONFIG_RECORD_FILE);
+		_fs->remove("/" CONFIG_RECORD_FILE ".tmp");
+	}
+	upload.plainPath = "";
+	updateAssetIndex(path);
+	_log.add(LOG_FS, okay ? LOG_INFO : LOG_ERROR, okay ? "Uploaded %s, %u bytes" : "Upload of %s failed after %u bytes", upload.size, 0, path.c_str());
+	upload.size = 0;
+}
+
+void AsyncFSWebServer::releaseUpload(AsyncWebServerRequest *request) {
+	AsyncFSUpload* upload = findUpload(request);
+	if (!upload) return;
+	if (upload->file) {
+		//interrupted upload
+		upload->status = 500;
+		finishUploadFile(*upload);
+	}
+	upload->end();
+}
+
+// text assets only, everything else is usually compressed already
+bool AsyncFSWebServer::isCompressible(const String& filename) {
+	//config files are read back by JSONtoSPIFFS and must stay plain
+	if (filename.endsWith(CONFIG_FILE) || filename.endsWith(SECRET_FILE)) return false;
+	return filename.endsWith(".html") || filename.endsWith(".htm") || filename.endsWith(".css") || filename.endsWith(".js") || filename.endsWith(".json");
+}
+
+//Micro-AJAX writers: one "key|value|type" line straight into the response stream
+void AsyncFSWebServer::printAjaxValue(Print& out, const char* key, const char* value, const char* type) {
+	out.print(key);
+	out.print('|');
+	out.print(value);
+	out.print('|');
+	out.print(type);
+	out.print('\n');
+}
+
+void AsyncFSWebServer::printAjaxEncoded(Print& out, const char* key, const char* value, const char* type) {
+	out.print(key);
+	out.print('|');
+	char block[3 * 16];
+	for (size_t left = strlen(value); left;) {
+		size_t n = (left < 16) ? left : 16;
+		out.write((const uint8_t*)block, uriEncode(value, n, block));
+		value += n;
+		left -= n;
+	}
+	out.print('|');
+	out.print(type);
+	out.print('\n');
+}
+
+void AsyncFSWebServer::printAjaxIP(Print& out, const char* key, const IPAddress& ip, const char* type) {
+	out.print(key);
+	out.print('|');
+	out.print(ip);
+	out.print('|');
+	out.print(type);
+	out.print('\n');
+}
+
+// Same formats as NtpClientLib, but into a caller supplied buffer (TIMESTR_LEN)
+const char* AsyncFSWebServer::formatTime(char* buf, time_t moment) {
+	snprintf(buf, TIMESTR_LEN, "%02d:%02d:%02d", hour(moment), minute(moment), second(moment));
+	return buf;
+}
+
+const char* AsyncFSWebServer::formatDate(char* buf, time_t moment) {
+	snprintf(buf, TIMESTR_LEN, "%02d/%02d/%4d", day(moment), month(moment), year(moment));
+	return buf;
+}
+
+const char* AsyncFSWebServer::formatTimeDate(char* buf, time_t moment) {
+	snprintf(buf, TIMESTR_LEN, "%02d:%02d:%02d %02d/%02d/%4d", hour(moment), minute(moment), second(moment), day(moment), month(moment), year(moment));
+	return buf;
+}
+
+const char* AsyncFSWebServer::formatUptime(char* buf, time_t uptime) {
+	uint8_t seconds = uptime % SECS_PER_MIN;
+	uint8_t minutes = (uptime / SECS_PER_MIN) % 60;
+	uint8_t hours = (uptime / SECS_PER_HOUR) % 24;
+	uint16_t days = uptime / SECS_PER_DAY;
+	snprintf(buf, TIMESTR_LEN, "%4u days %02d:%02d:%02d", days, hours, minutes, seconds);
+	return buf;
 }
 
 void AsyncFSWebServer::send_network_configuration_values_html(AsyncWebServerRequest *request) {
 	//Micro-AJAX
 	DEBUGLOG(__FUNCTION__);
 	DEBUGLOG("\r\n");
-	String values = "";
-	values += "ssid|" + encodeURIComponent(String(_config.ssid)) + "|input\n";
-	values += "password|" + encodeURIComponent(String(_config.password)) + "|input\n";
-	values += "ip|" + _config.ip.toString() + "|input\n";
-	values += "nm|" + _config.netmask.toString() + "|input\n";
-	values += "gw|" + _config.gateway.toString() + "|input\n";
-	values += "dns|" + _config.dns.toString() + "|input\n";
-	values += "dhcp|" + String(_config.dhcp ? "checked" : "") + "|chk\n";
-	request->send(200, "text/plain", values);
-	values = "";
+	AsyncFSPooledResponse *response = new AsyncFSPooledResponse("text/plain", 384);
+	printAjaxEncoded(*response, "ssid", _config.ssid.c_str(), "input");
+	printAjaxEncoded(*response, "password", _config.password.c_str(), "input");
+	printAjaxIP(*response, "ip", _config.ip, "input");
+	printAjaxIP(*response, "nm", _config.netmask, "input");
+	printAjaxIP(*response, "gw", _config.gateway, "input");
+	printAjaxIP(*response, "dns", _config.dns, "input");
+	printAjaxValue(*response, "dhcp", _config.dhcp ? "checked" : "", "chk");
+	sendResponse(request, response);
 }
 
 void AsyncFSWebServer::send_connection_state_values_html(AsyncWebServerRequest *request) {
 	//Micro-AJAX
 	DEBUGLOG(__FUNCTION__);
 	DEBUGLOG("\r\n");
-	String state;
+	const char* state;
 	switch (WiFi.status())
 	{
 	case 0: state = "Idle"; break;
@@ -558,34 +1297,41 @@ void AsyncFSWebServer::send_connection_state_values_html(AsyncWebServerRequest *
 	case 6: state = "DISCONNECTED"; break;
 	default: state = "N/A"; break;
 	}
-	//WiFi.scanNetworks(true);
-	String values = "";
-	values += "connectionstate|" + state + "|div\n";
-	request->send(200, "text/plain", values);
-	state = "";
-	values = "";
+	AsyncFSPooledResponse *response = new AsyncFSPooledResponse("text/plain", 64);
+	printAjaxValue(*response, "connectionstate", state, "div");
+	sendResponse(request, response);
 }
 
 void AsyncFSWebServer::send_information_values_html(AsyncWebServerRequest *request) {
 	//Micro-AJAX
 	DEBUGLOG(__FUNCTION__);
 	DEBUGLOG("\r\n");
-	String values = "";
-
-	values += "x_ssid|" + String(WiFi.SSID()) + "|div\n";
-	values += "x_ip|" + String(WiFi.localIP()[0]) + "." + String(WiFi.localIP()[1]) + "." + String(WiFi.localIP()[2]) + "." + String(WiFi.localIP()[3]) + "|div\n";
-	values += "x_gateway|" + String(WiFi.gatewayIP()[0]) + "." + String(WiFi.gatewayIP()[1]) + "." + String(WiFi.gatewayIP()[2]) + "." + String(WiFi.gatewayIP()[3]) + "|div\n";
-	values += "x_netmask|" + String(WiFi.subnetMask()[0]) + "." + String(WiFi.subnetMask()[1]) + "." + String(WiFi.subnetMask()[2]) + "." + String(WiFi.subnetMask()[3]) + "|div\n";
-	values += "x_mac|" + getMacAddress() + "|div\n";
-	values += "x_dns|" + String(WiFi.dnsIP()[0]) + "." + String(WiFi.dnsIP()[1]) + "." + String(WiFi.dnsIP()[2]) + "." + String(WiFi.dnsIP()[3]) + "|div\n";
-	values += "x_ntp_sync|" + NTP.getTimeDateString(NTP.getLastNTPSync()) + "|div\n";
-	values += "x_ntp_time|" + NTP.getTimeStr() + "|div\n";
-	values += "x_ntp_date|" + NTP.getDateStr() + "|div\n";
-	values += "x_uptime|" + NTP.getUptimeString() + "|div\n";
-	values += "x_last_boot|" + NTP.getTimeDateString(NTP.getLastBootTime()) + "|div\n";
-
-	request->send(200, "text/plain", values);
-	values = "";
+	AsyncFSPooledResponse *response = new AsyncFSPooledResponse("text/plain", 512);
+	char buf[TIMESTR_LEN];
+
+	//read SSID from the SDK config, WiFi.SSID() would return a heap String
+	struct station_config conf;
+	wifi_station_get_config(&conf);
+	char ssid[sizeof(conf.ssid) + 1];
+	memcpy(ssid, conf.ssid, sizeof(conf.ssid));
+	ssid[sizeof(conf.ssid)] = '\0';
+	printAjaxValue(*response, "x_ssid", ssid, "div");
+	printAjaxIP(*response, "x_ip", WiFi.localIP(), "div");
+	printAjaxIP(*response, "x_gateway", WiFi.gatewayIP(), "div");
+	printAjaxIP(*response, "x_netmask", WiFi.subnetMask(), "div");
+	uint8_t mac[6];
+	WiFi.macAddress(mac);
+	snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+	printAjaxValue(*response, "x_mac", buf, "div");
+	printAjaxIP(*response, "x_dns", WiFi.dnsIP(), "div");
+	printAjaxValue(*response, "x_ntp_sync", formatTimeDate(buf, NTP.getLastNTPSync()), "div");
+	time_t moment = now();
+	printAjaxValue(*response, "x_ntp_time", formatTime(buf, moment), "div");
+	printAjaxValue(*response, "x_ntp_date", formatDate(buf, moment), "div");
+	printAjaxValue(*response, "x_uptime", formatUptime(buf, NTP.getUptime()), "div");
+	printAjaxValue(*response, "x_last_boot", formatTimeDate(buf, NTP.getLastBootTime()), "div");
+
+	sendResponse(request, response);
 }
 
 String AsyncFSWebServer::getMacAddress() {
@@ -600,27 +1346,31 @@ void AsyncFSWebServer::send_NTP_configuration_values_html(AsyncWebServerRequest
 	//Micro-AJAX
 	DEBUGLOG(__FUNCTION__);
 	DEBUGLOG("\r\n");
-	String values = "";
-	values += "ntpserver|" + String(_config.ntpServerName) + "|input\n";
-	values += "update|" + String(_config.updateNTPTimeEvery) + "|input\n";
-	values += "tz|" + String(_config.timezone) + "|input\n";
-	values += "dst|" + String((_config.daylight ? "checked" : "")) + "|chk\n";
-	request->send(200, "text/plain", values);
-	values = "";
+	AsyncFSPooledResponse *response = new AsyncFSPooledResponse("text/plain", 192);
+	char buf[12];
+	printAjaxValue(*response, "ntpserver", _config.ntpServerName.c_str(), "input");
+	snprintf(buf, sizeof(buf), "%ld", _config.updateNTPTimeEvery);
+	printAjaxValue(*response, "update", buf, "input");
+	snprintf(buf, sizeof(buf), "%ld", _config.timezone);
+	printAjaxValue(*response, "tz", buf, "input");
+	printAjaxValue(*response, "dst", _config.daylight ? "checked" : "", "chk");
+	sendResponse(request, response);
 }
 
 void AsyncFSWebServer::send_system_configuration_values_html(AsyncWebServerRequest *request) {
 	//Micro-AJAX
 	DEBUGLOG(__FUNCTION__);
 	DEBUGLOG("\r\n");
-	String values = "";
-	values += String("devicename|" + _config.deviceName + "|input\n");
-	values += String("updateServer|" + _firmware.server + _firmware.path + "|input\n");
-	values += String("wwwauth|" + String(_httpAuth.auth ? "checked" : "") + "|chk\n");
-	values += String("wwwuser|" + _httpAuth.wwwUsername + "|input\n");
-	values += String("wwwpass|" + _httpAuth.wwwPassword + "|input\n");
-	request->send(200, "text/plain", values);
-	values = "";
+	AsyncFSPooledResponse *response = new AsyncFSPooledResponse("text/plain", 384);
+	printAjaxValue(*response, "devicename", _config.deviceName.c_str(), "input");
+	response->print("updateServer|");
+	response->print(_firmware.server);
+	response->print(_firmware.path);
+	response->print("|input\n");
+	printAjaxValue(*response, "wwwauth", _httpAuth.auth ? "checked" : "", "chk");
+	printAjaxValue(*response, "wwwuser", _httpAuth.wwwUsername.c_str(), "input");
+	printAjaxValue(*response, "wwwpass", _httpAuth.wwwPassword.c_str(), "input");
+	sendResponse(request, response);
 }
 
 void AsyncFSWebServer::evaluate_network_post_html(AsyncWebServerRequest *request) {
@@ -656,7 +1406,8 @@ void AsyncFSWebServer::evaluate_network_post_html(AsyncWebServerRequest *request
 				continue;
 			}
 		}
-		if (okay && save_config()) {
+		if (okay) {
+			markConfigDirty(CONFIG_DIRTY_CONFIG);
 			request->send(200, "text/plain", "OK");
 		}
 		else {
@@ -689,15 +1440,13 @@ void AsyncFSWebServer::evaluate_NTP_post_html(AsyncWebServerRequest *request) {
 				continue;
 			}
 		}
-		if (save_config()) {
-			NTP.setNtpServerName(_config.ntpServerName);
-			NTP.setInterval(_config.updateNTPTimeEvery * 60);
-			NTP.setTimeZone(_config.timezone / 10.0);
-			NTP.setDayLight(_config.daylight);
-			setTime(NTP.getTime());
-			request->send(200, "text/plain", "OK");
-		}
-		else request->send(200, "text/plain", "NOK: Error saving");
+		markConfigDirty(CONFIG_DIRTY_CONFIG);
+		NTP.setNtpServerName(_config.ntpServerName);
+		NTP.setInterval(_config.updateNTPTimeEvery * 60);
+		NTP.setTimeZone(_config.timezone / 10.0);
+		NTP.setDayLight(_config.daylight);
+		setTime(NTP.getTime());
+		request->send(200, "text/plain", "OK");
 	}
 	else {
 		request->send(200, "text/plain", "NOK: Bad Args");
@@ -745,11 +1494,11 @@ void AsyncFSWebServer::evaluate_system_post_html(AsyncWebServerRequest *request)
 				continue;
 			}
 		}
-		if (saveHTTPAuth() && save_config()) {
-			if (req_restart) request->send(200, "text/plain", "OK-RESTART");
-			else request->send(200, "text/plain", "OK");
-		}
-		else request->send(200, "text/plain", "NOK: Error saving");
+		//credentials may have changed => force a new login
+		clearSessions();
+		markConfigDirty(CONFIG_DIRTY_CONFIG | CONFIG_DIRTY_AUTH | CONFIG_DIRTY_FIRMWARE);
+		if (req_restart) request->send(200, "text/plain", "OK-RESTART");
+		else request->send(200, "text/plain", "OK");
 	}
 	else {
 		request->send(200, "text/plain", "NOK: Bad Args");
@@ -775,13 +1524,7 @@ bool AsyncFSWebServer::runUpdate() {
 }
 
 void AsyncFSWebServer::sendUpdateData() {
-	String data = "{";
-	data += "\"serverVer\":\"" + _firmware.serverVersion + "\",";
-	data += "\"clientVer\":\"" + _firmware.clientVersion + "\",";
-	data += "\"updPoss\":\"" + String((_firmware.updateAvailable && (ESP.getFreeSketchSpace() >= _firmware.updateSize))?"ja":"nein") + "\"";
-	data += "}\r\n";
-	_evsUpd.send(data.c_str(), "UpdData", 0, 500);
-	data = String();
+	_updDataPending = true;
 }
 
 void AsyncFSWebServer::checkFirmware() {
@@ -801,8 +1544,8 @@ void AsyncFSWebServer::checkFirmware() {
 		_asyncClient->onError([this](void* arg, AsyncClient* client, int error) {
 			_firmware.state = FW_ERROR;
 			_firmware.lastError = HTTP_ERROR_CONNECT_FAILED;
-			DEBUGLOG("[UPDATECHECK] Connect failed\r\n");
-			_evsUpd.send("10.20", "state",0,500);
+			_log.add(LOG_UPDATE, LOG_ERROR, "Check: connect to %s failed", 0, 0, _firmware.server.c_str());
+			publishUpdateState("10.20");
 			if (updatecallback) updatecallback(false, true, false, _firmware.lastError, _firmware.serverVersion, _firmware.updateSize);
 		}, NULL);
 		//define further callbacks
@@ -831,142 +1574,44 @@ void AsyncFSWebServer::checkFirmware() {
 					msg = "10.";
 					msg += String(_firmware.lastError);
 				}
-				_evsUpd.send(msg.c_str(), "state", 0, 500);
+				publishUpdateState(msg.c_str());
 				sendUpdateData();
 			}, NULL);
 
+			//parse the response header, it may arrive split over several segments
+			_firmware.updateAvailable = false;
+			_firmware.updateSize = 0;
+			_firmware.serverVersion = "";
+			_httpParser.reset();
+			_httpParser.onHeader([this](const char* name, size_t nameLen, const char* value, size_t valueLen) {
+				if (HTTPResponseParser::headerIs(name, nameLen, "x-esp8266-updateAvailable")) _firmware.updateAvailable = true;
+				else if (HTTPResponseParser::headerIs(name, nameLen, "x-esp8266-serverVersion")) HTTPResponseParser::assign(_firmware.serverVersion, value, valueLen);
+				else if (HTTPResponseParser::headerIs(name, nameLen, "x-esp8266-updateSize")) _firmware.updateSize = HTTPResponseParser::toUInt(value, valueLen);
+			});
+			_httpParser.onHeadersComplete([this](int statusCode) -> bool {
+				if (statusCode == 200) return true;
+				if (statusCode == 416) _firmware.lastError = FW_ERROR_NO_VERSION_FOR_MODEL;
+				else _firmware.lastError = HTTP_ERROR_INVALID_STATUSCODE;
+				_firmware.state = FW_ERROR;
+				return false;
+			});
+			_httpParser.onBody(NULL);
+
 			client->onData([this](void* arg, AsyncClient* c, void* data, size_t len) {
-				if (_firmware.state == FW_REQ_AV_PENDING) {
-					_firmware.state == FW_RECV_AV_PENDING;
-					//Parse header
-					uint8_t* d = (uint8_t*)data;
-					int statusCode = 0;
-					String headerLine = "";
-					bool CRFound = false;
-					enum ParseState {
-						//status code
-						PARSE_WAIT_STATUS_CODE,
-						PARSE_READING_STATUS_CODE,
-						PARSE_STATUS_CODE_READ,
-						PARSE_FIRST_SIGN,
-						PARSE_READING_HEADER,
-						PARSE_STARTING_CR_FOUND,
-						PARSE_BODY,
-						PARSE_SUCCESS
-					};
-					ParseState parseState = PARSE_WAIT_STATUS_CODE;
-					//pseudo regex
-					const char* statusPrefix = "HTTP/*.* ";
-					const char* statusPtr = statusPrefix;
-					for (size_t i = 0; ((i < len) && (_firmware.state != FW_ERROR) && (parseState != PARSE_SUCCESS)); i++) {
-						switch (parseState)
-						{
-						case PARSE_WAIT_STATUS_CODE:
-							//Skip Status Code Prefix (HTTP/*.* )
-							if ((*statusPtr == '*') || (*statusPtr == d[i]))
-							{
-								statusPtr++;
-								if (*statusPtr == '\0')
-								{
-									parseState = PARSE_READING_STATUS_CODE;
-								}
-							}
-							else
-							{
-								_firmware.lastError = HTTP_ERROR_INVALID_RESPONSE;
-								_firmware.state = FW_ERROR;
-							}
-							break;
-						case PARSE_READING_STATUS_CODE:
-							//Read Status Code
-							if (isdigit(d[i]))
-							{
-								statusCode = statusCode * 10 + (d[i] - '0');
-							}
-							else
-							{
-								//Check Status Code
-								if (statusCode == 200) {
-									_firmware.updateAvailable = false;
-									_firmware.updateSize = 0;
-									_firmware.serverVersion = "";
-									parseState = PARSE_STATUS_CODE_READ;
-								}
-								else if (statusCode == 416) {
-										_firmware.lastError = FW_ERROR_NO_VERSION_FOR_MODEL;
-										_firmware.state = FW_ERROR;
-								}
-								else {
-									_firmware.lastError = HTTP_ERROR_INVALID_STATUSCODE;
-									_firmware.state = FW_ERROR;
-								}
-							}
-							break;
-						case PARSE_STATUS_CODE_READ:
-							if (d[i] == '\n') {
-								parseState = PARSE_FIRST_SIGN;
-							}
-							break;
-						case PARSE_FIRST_SIGN:
-							if (d[i] == '\r')
-								parseState = PARSE_STARTING_CR_FOUND;
-							else {
-								headerLine = String(char(d[i])); //first sign of headerline
-								parseState = PARSE_READING_HEADER;
-							}
-							break;
-						case PARSE_READING_HEADER:
-							if (d[i] == '\r') CRFound = true;
-							else {
-								if (CRFound) {
-									CRFound = false;
-									if (d[i] == '\n') {
-										//evaluate header here
-										if (headerLine.indexOf(':') == -1) {
-											_firmware.lastError = HTTP_ERROR_INVALID_HEADER;
-											_firmware.state = FW_ERROR;
-										}
-										else {
-											String headerName = headerLine.substring(0, headerLine.indexOf(':'));
-											String headerValue = headerLine.substring(headerLine.indexOf(':') + 2);
-											if (headerName == "x-esp8266-updateAvailable") _firmware.updateAvailable = true;
-											if (headerName == "x-esp8266-serverVersion") _firmware.serverVersion = headerValue;
-											if (headerName == "x-esp8266-updateSize") _firmware.updateSize = static_cast<uint32_t>(headerValue.toInt());
-											//parse next header
-											parseState = PARSE_FIRST_SIGN;
-										}
-									}
-									else {
-										_firmware.lastError = HTTP_ERROR_INVALID_HEADER;
-										_firmware.state = FW_ERROR;
-									}
-								}
-								else {
-									//read header
-									headerLine += String(char(d[i]));
-								}
-							}
-							break;
-						case PARSE_STARTING_CR_FOUND:
-							if (d[i] == '\n') {
-								parseState = PARSE_SUCCESS;
-							}
-							else {
-								_firmware.lastError = HTTP_ERROR_INVALID_HEADER;
-								_firmware.state = FW_ERROR;
-							}
-							break;
-						default:
-							_firmware.lastError = HTTP_ERROR_INVALID_PARSESTATE;
+				if (_firmware.state == FW_REQ_AV_PENDING || _firmware.state == FW_RECV_AV_PENDING) {
+					_firmware.state = FW_RECV_AV_PENDING;
+					if (!_httpParser.parse((uint8_t*)data, len)) {
+						if (_firmware.state != FW_ERROR) {
+							_firmware.lastError = httpParserError();
 							_firmware.state = FW_ERROR;
-							break;
 						}
 					}
-					if (_firmware.state != FW_ERROR) {
+					else if (_httpParser.headersComplete()) {
 						if (_firmware.updateAvailable) _firmware.state = FW_IDLE;
 						else _firmware.state = FW_NO_UPDATE;
 					}
-					c->stop();
+					//header complete or error => done
+					if (_firmware.state != FW_RECV_AV_PENDING) c->stop();
 				}
 				else {
 					//Error
@@ -987,6 +1632,9 @@ void AsyncFSWebServer::checkFirmware() {
 			request += _firmware.modelName;
 			request += "\r\nX-ESP8266-CHECKUPDATE:\r\nX-ESP8266-VERSION: ";
 			request += _firmware.clientVersion;
+#ifdef FW_UPDATE_COMPRESSED
+			request += "\r\nX-ESP8266-ACCEPT-ENCODING: gzip";
+#endif
 			request += "\r\n\r\n";
 			client->write(request.c_str());
 		}, NULL);
@@ -995,24 +1643,27 @@ void AsyncFSWebServer::checkFirmware() {
 		if (!_asyncClient->connect(_firmware.server.c_str(), 80)) {
 			_firmware.state = FW_ERROR;
 			_firmware.lastError = HTTP_ERROR_CONNECT_FAILED;
-			DEBUGLOG("[UPDATECHECK] Connect failed\r\n");
-			_evsUpd.send("10.20", "state", 0, 500);
+			_log.add(LOG_UPDATE, LOG_ERROR, "Check: connect to %s failed", 0, 0, _firmware.server.c_str());
+			publishUpdateState("10.20");
 			if (updatecallback) updatecallback(false, true, false, _firmware.lastError, _firmware.serverVersion, _firmware.updateSize);
 		}
 	}
 	else {
-		_evsUpd.send("10.21", "state", 0, 500);
+		publishUpdateState("10.21");
 	}
 }
 
 void AsyncFSWebServer::updateFirmware(bool updSpiffs) {
 	DEBUGLOG(__FUNCTION__);
 	DEBUGLOG("\r\n");
-	if (_firmware.state == FW_IDLE || _firmware.state == FW_ERROR || _firmware.state == FW_NO_UPDATE) {
-		//spiffs or firmware?
-		_firmware.updSpiffs = updSpiffs;
-		if (_firmware.updSpiffs) _evsUpd.send("1", "state", 0, 500);
-		else _evsUpd.send("3", "state", 0, 500);
+	if (_firmware.state == FW_IDLE || _firmware.state == FW_ERROR || _firmware.state == FW_NO_UPDATE || _firmware.resuming) {
+		if (!_firmware.resuming) {
+			//spiffs or firmware?
+			_firmware.updSpiffs = updSpiffs;
+			if (_firmware.updSpiffs) publishUpdateState("1");
+			else publishUpdateState("3");
+			_firmware.resumeAttempts = 0;
+		}
 		//set state
 		_firmware.state = FW_REQ_BIN_PENDING;
 		//allocate new Client if it's not existing
@@ -1022,303 +1673,76 @@ void AsyncFSWebServer::updateFirmware(bool updSpiffs) {
 		if (!_asyncClient) return;
 		//define Error callback
 		_asyncClient->onError([this](void* arg, AsyncClient* client, int error) {
-			_firmware.state = FW_ERROR;
-			_firmware.lastError = HTTP_ERROR_CONNECT_FAILED;
-			DEBUGLOG("[UPDATE] Connect failed\r\n");
-			_evsUpd.send("10.20", "state", 0, 500);
-			if (updatecallback) updatecallback(true, true, false, _firmware.lastError, _firmware.serverVersion, _firmware.updateSize);
+			this->updateConnectFailed();
 		}, NULL);
 		//define further callbacks
 		_asyncClient->onConnect([this](void* arg, AsyncClient* client) {
 			client->onError(NULL, NULL);
 			client->onDisconnect([this](void* arg, AsyncClient* c) {
-				if (_firmware.state != FW_ERROR && _firmware.state != FW_IDLE && !_firmware.startFWupdate) {
-					_firmware.state = FW_ERROR;
-					_firmware.lastError = HTTP_ERROR_SERVER_DISCONNECTED;
-				}
-				//start FS if there was an error
-				if (_firmware.state == FW_ERROR) if (!_fs) _fs->begin();
-				DEBUGLOG("[UPDATE] HTTP Client disconnected\r\n");
-				//start FW Update
-				if (_firmware.startFWupdate && _firmware.state != FW_ERROR) {
-					_firmware.startFWupdate = false;
-					_firmware.state = FW_IDLE;
-					updateFirmware(false);
-				}
-				else {
-					//ERROR
-					//callback for info
-					if (_firmware.state == FW_IDLE) _firmware.lastError = FW_ERROR_NONE;
-					if (updatecallback) updatecallback(true, ((_firmware.state == FW_ERROR) ? true : false), _firmware.updatePossible, _firmware.lastError, _firmware.serverVersion, _firmware.updateSize);
-					//Event message
-					String msg;
-					if (_firmware.state == FW_IDLE) msg = "9"; //Update erfolgreich
-					else { //Error
-						msg = "10.";
-						msg += String(_firmware.lastError);
+				if (_firmware.state == FW_UPDATE_RUNNING) {
+					//image completely received but still staged => finish from handle() first
+					if (_fwStage.received >= _firmware.updateSize) {
+						_fwStage.clientClosed = true;
+						return;
 					}
-					_evsUpd.send(msg.c_str(), "state", 0, 500);
+					//connection lost mid-transfer => keep the Updater open and continue with a Range request
+					if (this->scheduleFirmwareResume()) return;
 				}
-				//restart ESP if Update completed
-				if (_restartESP) restart();
+				this->updateClientDisconnected();
 			}, NULL);
 
+			//parse the response header, it may arrive split over several segments
+			//(size and MD5 of a resumed download are kept and compared)
+			if (!_firmware.resuming) _firmware.updateSize = 0;
+			_firmware.rangeStart = 0;
+			_firmware.serverMD5 = "";
+			_firmware.rcvdSpiffs = false;
+			_firmware.compressed = false;
+			_fwStage.unacked = 0;
+			_httpParser.reset();
+			_httpParser.onHeader([this](const char* name, size_t nameLen, const char* value, size_t valueLen) {
+				if (HTTPResponseParser::headerIs(name, nameLen, "x-esp8266-updateSize")) _firmware.updateSize = HTTPResponseParser::toUInt(value, valueLen);
+				else if (HTTPResponseParser::headerIs(name, nameLen, "x-esp8266-MD5")) HTTPResponseParser::assign(_firmware.serverMD5, value, valueLen);
+				else if (HTTPResponseParser::headerIs(name, nameLen, "x-esp8266-SPIFFS")) _firmware.rcvdSpiffs = true;
+				else if (HTTPResponseParser::headerIs(name, nameLen, "x-esp8266-encoding")) _firmware.compressed = HTTPResponseParser::headerIs(value, valueLen, "gzip");
+				else if (HTTPResponseParser::headerIs(name, nameLen, "Content-Range")) {
+					//"bytes <start>-<end>/<total>"
+					while (valueLen && !isdigit(*value)) {
+						value++;
+						valueLen--;
+					}
+					_firmware.rangeStart = HTTPResponseParser::toUInt(value, valueLen);
+				}
+			});
+			_httpParser.onHeadersComplete([this](int statusCode) {
+				return this->startFirmwareWrite(statusCode);
+			});
+			_httpParser.onBody([this](const uint8_t* data, size_t len) {
+				return this->writeFirmwareData(data, len);
+			});
+
 			client->onData([this](void* arg, AsyncClient* c, void* data, size_t len) {
-				//first call => Parse Header
+				//first call
 				if (_firmware.state == FW_REQ_BIN_PENDING) {
-					if (_firmware.updSpiffs) _evsUpd.send("2", "state", 0, 500);
-					else _evsUpd.send("4", "state", 0, 500);
+					if (_firmware.updSpiffs) publishUpdateState("2");
+					else publishUpdateState("4");
 					DEBUGLOG("[UPDATE] parsing HTTP response...\r\n");
-					_firmware.state == FW_RECV_BIN_PENDING;
-					//Parse header
-					uint8_t* d = (uint8_t*)data;
-					int statusCode = 0;
-					String headerLine = "";
-					size_t headerLength;
-					bool CRFound = false;
-					enum ParseState {
-						//status code
-						PARSE_WAIT_STATUS_CODE,
-						PARSE_READING_STATUS_CODE,
-						PARSE_STATUS_CODE_READ,
-						PARSE_FIRST_SIGN,
-						PARSE_READING_HEADER,
-						PARSE_STARTING_CR_FOUND,
-						PARSE_BODY,
-						PARSE_SUCCESS
-					};
-					ParseState parseState = PARSE_WAIT_STATUS_CODE;
-					//pseudo regex
-					const char* statusPrefix = "HTTP/*.* ";
-					const char* statusPtr = statusPrefix;
-					for (size_t i = 0; ((i < len) && (_firmware.state != FW_ERROR)); i++) {
-						switch (parseState)
-						{
-						case PARSE_WAIT_STATUS_CODE:
-							//Skip Status Code Prefix (HTTP/*.* )
-							if ((*statusPtr == '*') || (*statusPtr == d[i]))
-							{
-								statusPtr++;
-								if (*statusPtr == '\0')
-								{
-									parseState = PARSE_READING_STATUS_CODE;
-									DEBUGLOG("[UPDATE] parsing HTTP Status Code...\r\n");
-								}
-							}
-							else
-							{
-								_firmware.lastError = HTTP_ERROR_INVALID_RESPONSE;
-								_firmware.state = FW_ERROR;
-								DEBUGLOG("[UPDATE] HTTP ERROR: Invalid response\r\n");
-							}
-							break;
-						case PARSE_READING_STATUS_CODE:
-							//Read Status Code
-							if (isdigit(d[i]))
-							{
-								statusCode = statusCode * 10 + (d[i] - '0');
-							}
-							else
-							{
-								DEBUGLOG("[UPDATE] HTTP Status Code: %d\r\n", statusCode);
-								//Check Status Code
-								if (statusCode == 200) {
-									_firmware.updateAvailable = false;
-									_firmware.updateSize = 0;
-									_firmware.serverMD5 = "";
-									_firmware.serverVersion = "";
-									_firmware.rcvdSpiffs = false;
-									parseState = PARSE_STATUS_CODE_READ;
-									DEBUGLOG("[UPDATE] Status Code okay\r\n");
-								}
-								else {
-									_firmware.lastError = HTTP_ERROR_INVALID_STATUSCODE;
-									_firmware.state = FW_ERROR;
-									//DEBUG****
-#ifndef RELEASE
-									switch (statusCode)
-									{
-									case 304: //no new Version
-										DEBUGLOG("[UPDATE] No NEW Version available for this model\r\n");
-										break;
-									case 400: //bad request
-										DEBUGLOG("[UPDATE] Bad HTTP Request\r\n");
-										break;
-									case 403: //forbidden
-										DEBUGLOG("[UPDATE] No Access\r\n");
-										break;
-									case 416: //no version for this model
-										DEBUGLOG("[UPDATE] No Version available for this model\r\n");
-										break;
-									}
-#endif //RELEASE
-								}
-							}
-							break;
-						case PARSE_STATUS_CODE_READ:
-							if (d[i] == '\n') {
-								parseState = PARSE_FIRST_SIGN;
-							}
-							break;
-						case PARSE_FIRST_SIGN:
-							if (d[i] == '\r')
-								parseState = PARSE_STARTING_CR_FOUND;
-							else {
-								headerLine = String(char(d[i]));
-								parseState = PARSE_READING_HEADER;
-								DEBUGLOG("[UPDATE] parsing Header..\r\n");
-							}
-							break;
-						case PARSE_READING_HEADER:
-							if (d[i] == '\r') CRFound = true;
-							else {
-								if (CRFound) {
-									CRFound = false;
-									if (d[i] == '\n') {
-										//evaluate header here
-										if (headerLine.indexOf(':') == -1) {
-											_firmware.lastError = HTTP_ERROR_INVALID_HEADER;
-											_firmware.state = FW_ERROR;
-											DEBUGLOG("[UPDATE] invalid Header..\r\n");
-										}
-										else {
-											String headerName = headerLine.substring(0, headerLine.indexOf(':'));
-											String headerValue = headerLine.substring(headerLine.indexOf(':') + 2);
-											if (headerName == "x-esp8266-updateSize") _firmware.updateSize = static_cast<uint32_t>(headerValue.toInt());
-											if (headerName == "x-esp8266-MD5") _firmware.serverMD5 = headerValue;
-											if (headerName == "x-esp8266-SPIFFS") _firmware.rcvdSpiffs = true;
-											DEBUGLOG("[UPDATE] Header parsed => name: %s; value: %s\r\n", headerName.c_str(), headerValue.c_str());
-											//parse next header
-											parseState = PARSE_FIRST_SIGN;
-										}
-									}
-									else {
-										_firmware.lastError = HTTP_ERROR_INVALID_HEADER;
-										_firmware.state = FW_ERROR;
-										DEBUGLOG("[UPDATE] invalid Header..\r\n");
-									}
-								}
-								else {
-									headerLine += String(char(d[i]));
-								}
-							}
-							break;
-						case PARSE_STARTING_CR_FOUND:
-							if (d[i] == '\n') {
-								parseState = PARSE_BODY;
-								headerLength = i + 1;
-								DEBUGLOG("[UPDATE] parsing Header finished, now parse body\r\n");
-							}
-							else {
-								_firmware.lastError = HTTP_ERROR_INVALID_HEADER;
-								_firmware.state = FW_ERROR;
-								DEBUGLOG("[UPDATE] invalid Header..\r\n");
-							}
-							break;
-						case PARSE_BODY:
-							//check Header Data
-							if (_firmware.updateSize <= 0 || _firmware.serverMD5 == "") {
-								_firmware.lastError = HTTP_ERROR_INVALID_HEADER;
-								_firmware.state = FW_ERROR;
-								DEBUGLOG("[UPDATE] Error: Size or MD5 Information missing...\r\n");
-							}
-							//check if it is SPIFFS bin if SPIFFS was requested
-							if (_firmware.rcvdSpiffs != _firmware.updSpiffs) {
-								_firmware.lastError = FW_ERROR_SPIFFS;
-								_firmware.state = FW_ERROR;
-								DEBUGLOG("[UPDATE] Error: SPIFFS mismatch...\r\n");
-							}
-							//start Update
-							if (_firmware.state != FW_UPDATE_RUNNING && _firmware.state != FW_ERROR) {						
-								if (_firmware.updSpiffs) {
-									DEBUGLOG("[UPDATE] Updating Spiffs\r\n");
-								}
-								else {
-									DEBUGLOG("[UPDATE] Updating FW");
-								}
-								_firmware.state = FW_UPDATE_RUNNING;
-								_fs->end();
-								Update.runAsync(true);
-								Update.setMD5(_firmware.serverMD5.c_str());
-								//start Updater or set Error
-								if (!Update.begin(_firmware.updateSize,(_firmware.updSpiffs?U_SPIFFS:U_FLASH))) {
-									_firmware.lastError = FW_ERROR_BEGIN_UPDATE;
-									_firmware.state = FW_ERROR;
-									Update.end(false); //reset Updater
-									DEBUGLOG("[UPDATE] Error begin Update...\r\n");
-								}
-								else {
-									_firmware.actSize = 0;
-									//write bin Bytes without http Header
-									uint8_t* d2 = (uint8_t*)data;
-									d2 += headerLength;
-									size_t written = Update.write(d2, len - headerLength);
-									_firmware.actSize += written;
-								}
-							}
-							break;
-						default:
-							_firmware.lastError = HTTP_ERROR_INVALID_PARSESTATE;
-							_firmware.state = FW_ERROR;
-							break;
-						}
+					_firmware.state = FW_RECV_BIN_PENDING;
+				}
+				if (_firmware.state == FW_RECV_BIN_PENDING || _firmware.state == FW_UPDATE_RUNNING) {
+					//ack only what the staging buffers can hold (back-pressure while flash is busy)
+					c->ackLater();
+					_fwStage.unacked += len;
+					if (!_httpParser.parse((uint8_t*)data, len) && (_firmware.state != FW_ERROR)) {
+						_firmware.lastError = httpParserError();
+						_firmware.state = FW_ERROR;
+						_log.add(LOG_UPDATE, LOG_ERROR, "Invalid HTTP response (parser error %u)", _httpParser.error());
 					}
 					if ((_firmware.state == FW_ERROR) && _asyncClient->connected()) {
 						DEBUGLOG("[UPDATE] Terminating Connection...\r\n");
 						c->stop();
 					}
-				}
-				else if (_firmware.state == FW_UPDATE_RUNNING) {
-					//write Date
-					uint8_t* d = (uint8_t*)data;
-					size_t written = Update.write(d, len);
-					_firmware.actSize += written;
-#ifndef RELEASE
-					static int lastProgress;
-					int tmpProgress = (_firmware.actSize * 100) / _firmware.updateSize;
-					if (tmpProgress != lastProgress) {//&& (tmpProgress % 10 == 0)) {
-						lastProgress = tmpProgress;						
-						DEBUGLOG("[UPDATE] updating... %d %%\r\n", tmpProgress);
-					}
-#endif
-					//end Update
-					if (_firmware.actSize >= _firmware.updateSize) {
-						if (Update.end(true)) {
-							if (_firmware.updSpiffs) {
-								DEBUGLOG("[UPDATE] SPIFFS Update finished => disconnecting and saving data...\r\n");
-								//SPIFFS update finished => start FS again and save config + callback, so user can save his config too
-								_fs->begin();
-								save_config();
-								saveHTTPAuth();
-								if (saveconfigcallback) saveconfigcallback();
-								//and start Firmware Update
-								DEBUGLOG("[UPDATE] data saved => disconnect Client and start FW update\r\n");
-								//start FW Update flag
-								_firmware.startFWupdate = true;
-								//Disconnect Client
-								if (_asyncClient->connected()) c->stop();
-							}
-							else {
-								//firmware update complete
-								_firmware.lastError = FW_ERROR_NONE;
-								_firmware.state = FW_IDLE;
-								//Disconnect Client
-								if (_asyncClient->connected()) c->stop();
-								DEBUGLOG("[UPDATE] FW update complete => restart\r\n");
-								//restart ESP
-								_restartESP = true;
-							}
-						}
-						else {
-							_firmware.lastError = FW_ERROR_END_UPDATE;
-							_firmware.state = FW_ERROR;
-							//Disconnect Client
-							if (_asyncClient->connected()) c->stop();
-							DEBUGLOG("[UPDATE] Error end update => restart\r\n");
-							//restart ESP
-							_restartESP = true;
-						}
-					}
+					else ackFirmwareStage(len);
 				}
 				else {
 					//Error
@@ -1344,11 +1768,20 @@ void AsyncFSWebServer::updateFirmware(bool updSpiffs) {
 				DEBUGLOG("[UPDATE] Preparing SPIFFS request...\r\n");
 				request += "\r\nX-ESP8266-SPIFFS: ";
 			}
-#ifndef RELEASE
 			else {
 				DEBUGLOG("[UPDATE] Preparing FW request...\r\n");
-			}
+#ifdef FW_UPDATE_COMPRESSED
+				//sketch may be sent gzipped, eboot inflates it on restart
+				request += "\r\nX-ESP8266-ACCEPT-ENCODING: gzip";
 #endif
+			}
+			//continue an interrupted download
+			if (_firmware.resuming) {
+				request += "\r\nRange: bytes=";
+				request += String(_fwStage.received);
+				request += "-";
+				DEBUGLOG("[UPDATE] Resuming at %u\r\n", _fwStage.received);
+			}
 			request += "\r\n\r\n";
 			DEBUGLOG("[UPDATE] Sending request...\r\n");
 			client->write(request.c_str());
@@ -1356,230 +1789,1048 @@ void AsyncFSWebServer::updateFirmware(bool updSpiffs) {
 
 		//connect to Server to send the request
 		if (!_asyncClient->connect(_firmware.server.c_str(), 80)) {
-			_firmware.state = FW_ERROR;
-			_firmware.lastError = HTTP_ERROR_CONNECT_FAILED;
-			DEBUGLOG("[UPDATE] Connect failed\r\n");
-			_evsUpd.send("10.20", "state", 0, 500);
-			if (updatecallback) updatecallback(true, true, false, _firmware.lastError, _firmware.serverVersion, _firmware.updateSize);
+			updateConnectFailed();
 		}
 	}
 	else {
-	 _evsUpd.send("10.21", "state", 0, 500);
+	 publishUpdateState("10.21");
 	}
 }
 
-void AsyncFSWebServer::serverInit() {
-	DEBUGLOG(__FUNCTION__);
-	DEBUGLOG("\r\n");
-	//SERVER INIT
-	//list directory
-	on("/list", HTTP_GET, [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->handleFileList(request);
-	});
-	//load editor
-	on("/edit", HTTP_GET, [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		if (!this->handleFileRead("/edit.html", request))
-			request->send(404, "text/plain", "FileNotFound");
-	});
-	//create file
-	on("/edit", HTTP_PUT, [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->handleFileCreate(request);
-	});
-	//delete file
-	on("/edit", HTTP_DELETE, [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->handleFileDelete(request);
-	});
-	//first callback is called after the request has ended with all parsed arguments
-	//second callback handles file uploads at that location
-	on("/edit", HTTP_POST, [](AsyncWebServerRequest *request) { request->send(200, "text/plain", ""); }, [this](AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final) {
-		this->handleFileUpload(request, filename, index, data, len, final);
-	});
+void AsyncFSWebServer::updateConnectFailed() {
+	//retry later if we are resuming an interrupted download
+	if (_firmware.resuming && scheduleFirmwareResume()) return;
+	_firmware.resuming = false;
+	releaseFirmwareStage();
+	if (Update.isRunning()) Update.end(false);
+	_firmware.state = FW_ERROR;
+	_firmware.lastError = HTTP_ERROR_CONNECT_FAILED;
+	_log.add(LOG_UPDATE, LOG_ERROR, "Connect to %s failed", 0, 0, _firmware.server.c_str());
+	publishUpdateState("10.20");
+	if (updatecallback) updatecallback(true, true, false, _firmware.lastError, _firmware.serverVersion, _firmware.updateSize);
+}
 
-	on("/admin/values/network", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->send_network_configuration_values_html(request);
-	});
-	on("/admin/values/connectionstate", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->send_connection_state_values_html(request);
-	});
-	on("/admin/values/info", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->send_information_values_html(request);
-	});
-	on("/admin/values/ntp", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->send_NTP_configuration_values_html(request);
-	});
-	on("/admin/values/system", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->send_system_configuration_values_html(request);
-	});
-	on("/admin/post/network", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->evaluate_network_post_html(request);
-	});
-	on("/admin/post/ntp", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->evaluate_NTP_post_html(request);
-	});
-	on("/admin/post/system", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->evaluate_system_post_html(request);
-	});
-	on("/admin/actions/scan", HTTP_GET, [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		String json = "[";
-		int n = WiFi.scanComplete();
-		if (n == WIFI_SCAN_FAILED) {
-			WiFi.scanNetworks(true);
+// Keeps the Updater (and with it the running MD5) open and reconnects later
+// to request the rest of the image. Returns false if no attempt is left.
+bool AsyncFSWebServer::scheduleFirmwareResume() {
+	if (_firmware.resumeAttempts >= FW_RESUME_ATTEMPTS) return false;
+	_firmware.resumeAttempts++;
+	if (!_firmware.resuming) _firmware.resumeMD5 = _firmware.serverMD5;
+	_firmware.resuming = true;
+	_log.add(LOG_UPDATE, LOG_WARN, "Download interrupted at %u, resume attempt %u", _fwStage.received, _firmware.resumeAttempts);
+	_fwResumeTk.once(FW_RESUME_DELAY * _firmware.resumeAttempts, &AsyncFSWebServer::s_resumeFirmware, static_cast<void*>(this));
+	return true;
+}
+
+void AsyncFSWebServer::s_resumeFirmware(void* arg) {
+	AsyncFSWebServer* self = reinterpret_cast<AsyncFSWebServer*>(arg);
+	self->updateFirmware(self->_firmware.updSpiffs);
+}
+
+enumFirmwareLastError AsyncFSWebServer::httpParserError() {
+	switch (_httpParser.error())
+	{
+	case HTTP_PARSE_ERROR_RESPONSE: return HTTP_ERROR_INVALID_RESPONSE;
+	case HTTP_PARSE_ERROR_HEADER:
+	case HTTP_PARSE_ERROR_LINE_TOO_LONG:
+	case HTTP_PARSE_ERROR_CHUNK: return HTTP_ERROR_INVALID_HEADER;
+	default: return HTTP_ERROR_INVALID_PARSESTATE;
+	}
+}
+
+// called once the response header of a binary request is complete
+bool AsyncFSWebServer::startFirmwareWrite(int statusCode) {
+	_log.add(LOG_UPDATE, LOG_DEBUG, "HTTP status %d", statusCode);
+	//continue an interrupted download if the server sent the rest of the same image
+	if (_firmware.resuming) {
+		_firmware.resuming = false;
+		if ((statusCode == 206) && (_firmware.rangeStart == _fwStage.received) && (_firmware.serverMD5 == _firmware.resumeMD5)) {
+			_log.add(LOG_UPDATE, LOG_INFO, "Download resumed at %u", _firmware.rangeStart);
+			_firmware.resumeAttempts = 0;
+			_firmware.state = FW_UPDATE_RUNNING;
+			return true;
+		}
+		//no (matching) range => start over
+		_log.add(LOG_UPDATE, LOG_WARN, "Resume not possible, restarting download");
+		releaseFirmwareStage();
+		if (Update.isRunning()) Update.end(false);
+	}
+	if (statusCode != 200) {
+		_firmware.lastError = HTTP_ERROR_INVALID_STATUSCODE;
+		_firmware.state = FW_ERROR;
+		//DEBUG****
+#ifndef RELEASE
+		switch (statusCode)
+		{
+		case 304: //no new Version
+			_log.add(LOG_UPDATE, LOG_INFO, "No new version for model %s", 0, 0, _firmware.modelName.c_str());
+			break;
+		case 400: //bad request
+			_log.add(LOG_UPDATE, LOG_ERROR, "Server answered: bad request");
+			break;
+		case 403: //forbidden
+			_log.add(LOG_UPDATE, LOG_ERROR, "Server answered: no access");
+			break;
+		case 416: //no version for this model
+			_log.add(LOG_UPDATE, LOG_ERROR, "No version for model %s", 0, 0, _firmware.modelName.c_str());
+			break;
 		}
-		else if (n) {
-			for (int i = 0; i < n; ++i) {
-				if (i) json += ",";
-				json += "{";
-				json += "\"rssi\":" + String(WiFi.RSSI(i));
-				json += ",\"ssid\":\"" + WiFi.SSID(i) + "\"";
-				json += ",\"bssid\":\"" + WiFi.BSSIDstr(i) + "\"";
-				json += ",\"channel\":" + String(WiFi.channel(i));
-				json += ",\"secure\":" + String(WiFi.encryptionType(i));
-				json += ",\"hidden\":" + String(WiFi.isHidden(i) ? "true" : "false");
-				json += "}";
+#endif //RELEASE
+		return false;
+	}
+	//check Header Data
+	if (_firmware.updateSize <= 0 || _firmware.serverMD5 == "") {
+		_firmware.lastError = HTTP_ERROR_INVALID_HEADER;
+		_firmware.state = FW_ERROR;
+		_log.add(LOG_UPDATE, LOG_ERROR, "Size or MD5 missing in response");
+		return false;
+	}
+	//check if it is SPIFFS bin if SPIFFS was requested (SPIFFS images are never compressed)
+	if ((_firmware.rcvdSpiffs != _firmware.updSpiffs) || (_firmware.updSpiffs && _firmware.compressed)) {
+		_firmware.lastError = FW_ERROR_SPIFFS;
+		_firmware.state = FW_ERROR;
+		_log.add(LOG_UPDATE, LOG_ERROR, "SPIFFS flag mismatch");
+		return false;
+	}
+	//start Update
+	if (_firmware.updSpiffs) {
+		_log.add(LOG_UPDATE, LOG_INFO, "Updating SPIFFS, %u bytes", _firmware.updateSize);
+	}
+	else {
+		_log.add(LOG_UPDATE, LOG_INFO, "Updating firmware, %u bytes%s", _firmware.updateSize, 0, _firmware.compressed ? " (gzip)" : "");
+	}
+	_fs->end();
+	Update.runAsync(true);
+	Update.setMD5(_firmware.serverMD5.c_str());
+	//start Updater or set Error
+	if (!Update.begin(_firmware.updateSize, (_firmware.updSpiffs ? U_SPIFFS : U_FLASH))) {
+		_firmware.lastError = FW_ERROR_BEGIN_UPDATE;
+		_firmware.state = FW_ERROR;
+		Update.end(false); //reset Updater
+		_log.add(LOG_UPDATE, LOG_ERROR, "Update.begin() failed, error %u", Update.getError());
+		return false;
+	}
+	_firmware.actSize = 0;
+	_firmware.state = FW_UPDATE_RUNNING;
+	initFirmwareStage();
+	return true;
+}
+
+// body bytes of a binary request (without HTTP header / chunk framing)
+// Data is only copied into the sector buffers here, flash is written from handle().
+bool AsyncFSWebServer::writeFirmwareData(const uint8_t* data, size_t len) {
+	//ignore anything after the image was completed
+	if (_firmware.state != FW_UPDATE_RUNNING) return true;
+	_fwStage.received += len;
+	if (!_fwStage.buf[0]) {
+		//no staging memory => write synchronously
+		if (!flashFirmwareData(data, len)) return false;
+		if (_firmware.actSize >= _firmware.updateSize) finishFirmwareUpdate();
+		return true;
+	}
+	while (len) {
+		uint8_t a = _fwStage.active;
+		size_t n = FW_STAGE_SECTOR - _fwStage.fill[a];
+		if (n > len) n = len;
+		memcpy(_fwStage.buf[a] + _fwStage.fill[a], data, n);
+		_fwStage.fill[a] += n;
+		data += n;
+		len -= n;
+		//sector full or image complete => hand buffer over to handle()
+		if ((_fwStage.fill[a] == FW_STAGE_SECTOR) || (!len && (_fwStage.received >= _firmware.updateSize))) {
+			_fwStage.full[a] = true;
+			uint8_t other = a ^ 1;
+			//handle() did not keep up => write the older sector now
+			if (_fwStage.full[other] && !flushStageBuffer(other)) return false;
+			_fwStage.active = other;
+		}
+	}
+	return true;
+}
+
+bool AsyncFSWebServer::flashFirmwareData(const uint8_t* data, size_t len) {
+	size_t written = Update.write(const_cast<uint8_t*>(data), len);
+	_firmware.actSize += written;
+#ifndef RELEASE
+	static int lastProgress;
+	int tmpProgress = (_firmware.actSize * 100) / _firmware.updateSize;
+	if (tmpProgress != lastProgress) {//&& (tmpProgress % 10 == 0)) {
+		lastProgress = tmpProgress;
+		DEBUGLOG("[UPDATE] updating... %d %%\r\n", tmpProgress);
+	}
+#endif
+	if (written != len) {
+		_firmware.lastError = FW_ERROR_END_UPDATE;
+		_firmware.state = FW_ERROR;
+		if (_asyncClient->connected()) _asyncClient->stop();
+		_log.add(LOG_UPDATE, LOG_ERROR, "Flash write failed at %u, error %u", _firmware.actSize, Update.getError());
+		return false;
+	}
+	return true;
+}
+
+bool AsyncFSWebServer::flushStageBuffer(uint8_t i) {
+	bool okay = flashFirmwareData(_fwStage.buf[i], _fwStage.fill[i]);
+	_fwStage.fill[i] = 0;
+	_fwStage.full[i] = false;
+	return okay;
+}
+
+// called from handle(), outside of the network callbacks
+void AsyncFSWebServer::flushFirmwareStage() {
+	//keeps flushing while a resume request is pending
+	if ((_firmware.state == FW_ERROR) || !_fwStage.buf[0]) return;
+	uint8_t ready = _fwStage.active ^ 1;
+	if (!_fwStage.full[ready]) {
+		//the last segment of onData can only be acked from here
+		ackFirmwareStage();
+		return;
+	}
+	if (!flushStageBuffer(ready)) return;
+	ackFirmwareStage();
+	if (_firmware.actSize >= _firmware.updateSize) finishFirmwareUpdate();
+}
+
+// Acks received bytes to TCP as far as the free staging space allows, so the
+// sender can never have more data in flight than we are able to buffer.
+// Inside onData the current segment (current bytes) is only ackable after the
+// callback returned, AsyncClient::ack() would silently cap it.
+void AsyncFSWebServer::ackFirmwareStage(size_t current) {
+	if ((_fwStage.unacked <= current) || !_asyncClient || !_asyncClient->connected()) return;
+	size_t keep = 0;
+	if (_fwStage.buf[0]) {
+		size_t freeSpace = 2 * FW_STAGE_SECTOR - _fwStage.fill[0] - _fwStage.fill[1];
+		if (FW_STAGE_TCP_WND > freeSpace) keep = FW_STAGE_TCP_WND - freeSpace;
+	}
+	if (keep < current) keep = current;
+	if (_fwStage.unacked > keep) {
+		_asyncClient->ack(_fwStage.unacked - keep);
+		_fwStage.unacked = keep;
+	}
+}
+
+void AsyncFSWebServer::initFirmwareStage() {
+	releaseFirmwareStage();
+	_fwStage.buf[0] = (uint8_t*)malloc(FW_STAGE_SECTOR);
+	_fwStage.buf[1] = (uint8_t*)malloc(FW_STAGE_SECTOR);
+	if (!_fwStage.buf[0] || !_fwStage.buf[1]) {
+		//not enough heap => fall back to writing from the network callback
+		releaseFirmwareStage();
+		_log.add(LOG_UPDATE, LOG_WARN, "No memory for staging, writing synchronously");
+	}
+	_fwStage.fill[0] = _fwStage.fill[1] = 0;
+	_fwStage.full[0] = _fwStage.full[1] = false;
+	_fwStage.active = 0;
+	_fwStage.received = 0;
+	_fwStage.clientClosed = false;
+	_fwStage.startTime = millis();
+}
+
+void AsyncFSWebServer::releaseFirmwareStage() {
+	free(_fwStage.buf[0]);
+	free(_fwStage.buf[1]);
+	_fwStage.buf[0] = _fwStage.buf[1] = NULL;
+}
+
+void AsyncFSWebServer::finishFirmwareUpdate() {
+	uint32_t duration = millis() - _fwStage.startTime;
+	_fwStage.throughput = duration ? (uint32_t)((uint64_t)_firmware.actSize * 1000 / duration) : 0;
+	_log.add(LOG_UPDATE, LOG_INFO, "%u bytes in %u ms", _firmware.actSize, duration);
+	releaseFirmwareStage();
+	bool clientClosed = _fwStage.clientClosed;
+	_fwStage.clientClosed = false;
+	if (Update.end(true)) {
+		if (_firmware.updSpiffs) {
+			DEBUGLOG("[UPDATE] SPIFFS Update finished => disconnecting and saving data...\r\n");
+			//SPIFFS update finished => start FS again and save config + callback, so user can save his config too
+			_fs->begin();
+			save_config(); //the record contains the secret too
+			if (saveconfigcallback) saveconfigcallback();
+			//and start Firmware Update
+			DEBUGLOG("[UPDATE] data saved => disconnect Client and start FW update\r\n");
+			//start FW Update flag
+			_firmware.startFWupdate = true;
+			_firmware.state = FW_RECV_BIN_PENDING;
+		}
+		else {
+			//firmware update complete
+			_firmware.lastError = FW_ERROR_NONE;
+			_firmware.state = FW_IDLE;
+			_log.add(LOG_UPDATE, LOG_INFO, "Firmware update complete, restarting");
+			//restart ESP
+			_restartESP = true;
+		}
+	}
+	else {
+		_firmware.lastError = FW_ERROR_END_UPDATE;
+		_firmware.state = FW_ERROR;
+		_log.add(LOG_UPDATE, LOG_ERROR, "Update.end() failed, error %u", Update.getError());
+		//restart ESP
+		_restartESP = true;
+	}
+	//Disconnect Client, the disconnect handler continues
+	if (_asyncClient->connected()) _asyncClient->stop();
+	else if (clientClosed) updateClientDisconnected();
+}
+
+void AsyncFSWebServer::updateClientDisconnected() {
+	if (_firmware.state != FW_ERROR && _firmware.state != FW_IDLE && !_firmware.startFWupdate) {
+		_firmware.state = FW_ERROR;
+		_firmware.lastError = HTTP_ERROR_SERVER_DISCONNECTED;
+	}
+	//abort a running update and free the staging buffers
+	if (_firmware.state == FW_ERROR) {
+		_firmware.resuming = false;
+		releaseFirmwareStage();
+		if (Update.isRunning()) Update.end(false);
+	}
+	//start FS if there was an error
+	if (_firmware.state == FW_ERROR) if (!_fs) _fs->begin();
+	DEBUGLOG("[UPDATE] HTTP Client disconnected\r\n");
+	//start FW Update
+	if (_firmware.startFWupdate && _firmware.state != FW_ERROR) {
+		_firmware.startFWupdate = false;
+		_firmware.state = FW_IDLE;
+		updateFirmware(false);
+	}
+	else {
+		//ERROR
+		//callback for info
+		if (_firmware.state == FW_IDLE) _firmware.lastError = FW_ERROR_NONE;
+		if (updatecallback) updatecallback(true, ((_firmware.state == FW_ERROR) ? true : false), _firmware.updatePossible, _firmware.lastError, _firmware.serverVersion, _firmware.updateSize);
+		//Event message
+		String msg;
+		if (_firmware.state == FW_IDLE) msg = "9"; //Update erfolgreich
+		else { //Error
+			msg = "10.";
+			msg += String(_firmware.lastError);
+		}
+		publishUpdateState(msg.c_str());
+	}
+	//restart ESP if Update completed
+	if (_restartESP) restart();
+}
+
+// FNV-1a, evaluated by the compiler for the route table
+static constexpr uint32_t routeHash(const char* s, uint32_t h = 2166136261u) {
+	return *s ? routeHash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+// same hash over the first len characters
+static uint32_t routeHashLen(const char* s, size_t len) {
+	uint32_t h = 2166136261u;
+	while (len--) h = (h ^ (uint8_t)*s++) * 16777619u;
+	return h;
+}
+
+#define ROUTE(path, methods, auth, handler) { path, routeHash(path), methods, auth, false, &AsyncFSWebServer::handler }
+#define PREFIX_ROUTE(path, methods, auth, handler) { path, routeHash(path), methods, auth, true, &AsyncFSWebServer::handler }
+
+const strRoute AsyncFSWebServer::_routes[] = {
+	ROUTE("/list", HTTP_GET, true, handleFileList), //list directory
+	ROUTE("/edit", HTTP_GET, true, handleEditPage), //load editor
+	ROUTE("/edit", HTTP_PUT, true, handleFileCreate), //create file
+	ROUTE("/edit", HTTP_DELETE, true, handleFileDelete), //delete file
+	ROUTE("/edit", HTTP_POST, true, handleUploadDone), //upload, data goes to handleFileUpload
+	ROUTE("/admin/values/network", HTTP_ANY, true, send_network_configuration_values_html),
+	ROUTE("/admin/values/connectionstate", HTTP_ANY, true, send_connection_state_values_html),
+	ROUTE("/admin/values/info", HTTP_ANY, true, send_information_values_html),
+	ROUTE("/admin/values/ntp", HTTP_ANY, true, send_NTP_configuration_values_html),
+	ROUTE("/admin/values/system", HTTP_ANY, true, send_system_configuration_values_html),
+	ROUTE("/admin/post/network", HTTP_ANY, true, evaluate_network_post_html),
+	ROUTE("/admin/post/ntp", HTTP_ANY, true, evaluate_NTP_post_html),
+	ROUTE("/admin/post/system", HTTP_ANY, true, evaluate_system_post_html),
+	ROUTE("/admin/actions/scan", HTTP_GET, true, handleScan),
+	ROUTE("/admin/actions/restart", HTTP_ANY, true, handleRestart),
+	ROUTE("/admin/actions/factoryReset", HTTP_POST, true, handleFactoryReset),
+	ROUTE("/admin/update/checkUpdate", HTTP_ANY, true, handleCheckUpdate),
+	ROUTE("/admin/update/doUpdate", HTTP_ANY, true, handleDoUpdate),
+	ROUTE("/admin/log", HTTP_GET, true, handleLog),
+	PREFIX_ROUTE("/admin", HTTP_ANY, true, handleAdminPage),
+	PREFIX_ROUTE("/json", HTTP_ANY, true, handleJSON),
+	PREFIX_ROUTE("/rest", HTTP_ANY, true, handleREST),
+	PREFIX_ROUTE("/post", HTTP_ANY, true, handlePOST),
+#ifdef HIDE_SECRET
+	ROUTE("/" SECRET_FILE, HTTP_GET, true, handleForbidden),
+#endif // HIDE_SECRET
+#if defined(HIDE_SECRET) || defined(HIDE_CONFIG)
+	//holds config and secret, incl. the WiFi password
+	ROUTE("/" CONFIG_RECORD_FILE, HTTP_GET, true, handleForbidden),
+	ROUTE("/" CONFIG_RECORD_FILE ".tmp", HTTP_GET, true, handleForbidden),
+#endif
+#ifdef HIDE_CONFIG
+	ROUTE("/" CONFIG_FILE, HTTP_GET, true, handleForbidden),
+#endif // HIDE_CONFIG
+	ROUTE("/metrics", HTTP_GET, true, handleMetrics), //counters in Prometheus text format
+	ROUTE("/all", HTTP_GET, false, handleAll) //get heap status, analog input value and all GPIO statuses in one json call
+};
+
+const size_t AsyncFSWebServer::_routeCount = sizeof(AsyncFSWebServer::_routes) / sizeof(AsyncFSWebServer::_routes[0]);
+
+const strRoute* AsyncFSWebServer::findRoute(AsyncWebServerRequest *request) {
+	const String& url = request->url();
+	const strRoute* route = lookupRoute(url.c_str(), url.length(), request->method(), false);
+	if (route) return route;
+	//"/rest/x" goes to the "/rest" handler, the callback reads the rest of the URL
+	int slash = url.indexOf('/', 1);
+	if (slash < 0) return NULL;
+	return lookupRoute(url.c_str(), slash, request->method(), true);
+}
+
+const strRoute* AsyncFSWebServer::lookupRoute(const char* path, size_t len, WebRequestMethodComposite method, bool prefix) {
+	uint32_t hash = routeHashLen(path, len);
+	//first route with this hash
+	size_t lo = 0;
+	size_t hi = _routeOrder.size();
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (_routes[_routeOrder[mid]].hash < hash) lo = mid + 1;
+		else hi = mid;
+	}
+	//same path may be registered for several methods
+	for (; (lo < _routeOrder.size()) && (_routes[_routeOrder[lo]].hash == hash); lo++) {
+		const strRoute* route = &_routes[_routeOrder[lo]];
+		if (prefix && !route->prefix) continue;
+		if ((route->methods & method) && (strncmp(route->path, path, len) == 0) && !route->path[len]) return route;
+	}
+	return NULL;
+}
+
+bool AsyncFSUpload::begin(AsyncWebServerRequest* req) {
+	_batch = (uint8_t*)slabAlloc(UPLOAD_BATCH_SIZE);
+	if (!_batch) return false;
+	_batchFill = 0;
+	request = req;
+	size = 0;
+	status = 200;
+	return true;
+}
+
+void AsyncFSUpload::end() {
+	slabFree(_batch);
+	_batch = NULL;
+	_batchFill = 0;
+	request = NULL;
+}
+
+bool AsyncFSUpload::flushBatch() {
+	if (!_batchFill) return true;
+	bool okay = file && (file.write(_batch, _batchFill) == _batchFill);
+	_batchFill = 0;
+	return okay;
+}
+
+size_t AsyncFSUpload::write(uint8_t c) {
+	return write(&c, 1);
+}
+
+size_t AsyncFSUpload::write(const uint8_t* data, size_t len) {
+	size_t done = 0;
+	while (done < len) {
+		size_t n = UPLOAD_BATCH_SIZE - _batchFill;
+		if (n > len - done) n = len - done;
+		memcpy(_batch + _batchFill, data + done, n);
+		_batchFill += n;
+		done += n;
+		if ((_batchFill == UPLOAD_BATCH_SIZE) && !flushBatch()) return 0;
+	}
+	return len;
+}
+
+AsyncFSPooledResponse::AsyncFSPooledResponse(const String& contentType, size_t sizeHint) : _content(sizeHint) {
+	_code = 200;
+	_contentLength = 0;
+	_contentType = contentType;
+	_readPos = 0;
+}
+
+size_t AsyncFSPooledResponse::write(uint8_t c) {
+	return write(&c, 1);
+}
+
+size_t AsyncFSPooledResponse::write(const uint8_t* data, size_t len) {
+	size_t written = _content.write(data, len);
+	_contentLength = _content.length();
+	return written;
+}
+
+size_t AsyncFSPooledResponse::_fillBuffer(uint8_t* buf, size_t maxLen) {
+	size_t n = _content.length() - _readPos;
+	if (n > maxLen) n = maxLen;
+	memcpy(buf, _content.data() + _readPos, n);
+	_readPos += n;
+	return n;
+}
+
+bool AsyncFSAdmissionHandler::canHandle(AsyncWebServerRequest *request) {
+	return !_server->admitRequest(request);
+}
+
+void AsyncFSAdmissionHandler::handleRequest(AsyncWebServerRequest *request) {
+	AsyncWebServerResponse *response = request->beginResponse(503, "text/plain", "Server busy");
+	response->addHeader("Retry-After", ADMISSION_RETRY_AFTER);
+	request->send(response);
+}
+
+// Called once per request ahead of all other handlers, false => 503
+bool AsyncFSWebServer::admitRequest(AsyncWebServerRequest *request) {
+	//event streams and websockets hand the connection to their own client right away
+	AsyncWebHeader* accept = request->getHeader("Accept");
+	if ((accept && (accept->value().indexOf("text/event-stream") >= 0)) || request->hasHeader("Upgrade")) return true;
+	for (size_t i = 0; i < _admitted.size(); i++) {
+		//same address => the earlier request was deleted already
+		if (_admitted[i].request != request) continue;
+		releaseUpload(request);
+		_admitted.erase(_admitted.begin() + i);
+		break;
+	}
+	const String& url = request->url();
+	uint8_t limit = _maxRequests;
+	if (!url.startsWith("/admin") && !url.startsWith("/edit")) limit -= ADMISSION_RESERVED;
+	//handle() may not have run since the last connections closed
+	if (_admitted.size() >= limit) expireAdmissions();
+	if (_admitted.size() >= limit) {
+		_requestsRejected++;
+		_log.add(LOG_HTTP, LOG_WARN, "Busy (%u in flight), rejected %s", (uint32_t)_admitted.size(), 0, url.c_str());
+		return false;
+	}
+	AsyncClient* client = request->client();
+	strAdmissionSlot slot = { request, client->getRemoteAddress(), client->getRemotePort(), client->getLocalPort() };
+	_admitted.push_back(slot);
+	if (_admitted.size() > _requestsPeak) _requestsPeak = _admitted.size();
+	return true;
+}
+
+// lwIP lists a connection as active until its close handshake is done.
+// Whichever handler ended the request, the AsyncClient is gone by then.
+static bool connectionOpen(const strAdmissionSlot& slot) {
+	for (struct tcp_pcb* pcb = tcp_active_pcbs; pcb; pcb = pcb->next) {
+		if ((pcb->remote_port != slot.remotePort) || (pcb->local_port != slot.localPort)) continue;
+#if LWIP_VERSION_MAJOR == 1
+		if (pcb->remote_ip.addr == slot.remoteIP) return true;
+#else
+		if (ip_addr_get_ip4_u32(&pcb->remote_ip) == slot.remoteIP) return true;
+#endif
+	}
+	return false;
+}
+
+// Frees the slots of closed connections, also an upload they left unfinished
+void AsyncFSWebServer::expireAdmissions() {
+	for (size_t i = _admitted.size(); i-- > 0; ) {
+		if (connectionOpen(_admitted[i])) continue;
+		releaseUpload(_admitted[i].request);
+		_admitted.erase(_admitted.begin() + i);
+	}
+}
+
+// The match is kept for handleRequest(), so a request is hashed and looked up once
+bool AsyncFSRouteHandler::canHandle(AsyncWebServerRequest *request) {
+	const strRoute* route = _server->findRoute(request);
+	if (!route) return false;
+	request->addInterestingHeader("ANY");
+	//a new request may reuse the address of one that never reached handleRequest()
+	strPendingRoute* slot = NULL;
+	for (uint8_t i = 0; (i < ROUTE_PENDING) && !slot; i++) {
+		if (_pending[i].request == request) slot = &_pending[i];
+	}
+	for (uint8_t i = 0; (i < ROUTE_PENDING) && !slot; i++) {
+		if (!_pending[i].request) slot = &_pending[i];
+	}
+	if (!slot) {
+		slot = &_pending[_nextPending];
+		_nextPending = (_nextPending + 1) % ROUTE_PENDING;
+	}
+	slot->request = request;
+	slot->route = route;
+	return true;
+}
+
+const strRoute* AsyncFSRouteHandler::takeRoute(AsyncWebServerRequest *request) {
+	for (uint8_t i = 0; i < ROUTE_PENDING; i++) {
+		if (_pending[i].request == request) {
+			_pending[i].request = NULL;
+			return _pending[i].route;
+		}
+	}
+	//replaced by other requests while the body was received
+	return _server->findRoute(request);
+}
+
+void AsyncFSRouteHandler::handleRequest(AsyncWebServerRequest *request) {
+	const strRoute* route = takeRoute(request);
+	if (!route) return request->send(404, "text/plain", "FileNotFound");
+	enumAuthResult auth = route->auth ? _server->checkAuth(request) : AUTH_GRANTED;
+	if (auth == AUTH_DENIED) {
+		_server->recordRequest(route, 0, true);
+		_server->_log.add(LOG_HTTP, LOG_DEBUG, "Auth required: %s", 0, 0, route->path);
+		return request->requestAuthentication();
+	}
+	uint32_t start = micros();
+	//handlers answer synchronously, sendResponse() adds the cookie for this request only
+	_server->_sessionRequest = (auth == AUTH_NEW_SESSION) ? request : NULL;
+	(_server->*(route->handler))(request);
+	_server->_sessionRequest = NULL;
+	_server->recordRequest(route, micros() - start, false);
+}
+
+void AsyncFSRouteHandler::handleUpload(AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) {
+	if ((request->method() == HTTP_POST) && (request->url() == "/edit"))
+		_server->handleFileUpload(request, filename, index, data, len, final);
+}
+
+void AsyncFSWebServer::handleEditPage(AsyncWebServerRequest *request) {
+	if (!handleFileRead("/edit.html", request))
+		request->send(404, "text/plain", "FileNotFound");
+}
+
+void AsyncFSWebServer::handleUploadDone(AsyncWebServerRequest *request) {
+	int status = 200;
+	AsyncFSUpload* upload = findUpload(request);
+	if (upload) {
+		finishUploadFile(*upload);
+		status = upload->status;
+		releaseUpload(request);
+	}
+	else {
+		//a file was sent but there was no free slot for it
+		for (size_t i = 0; i < request->params(); i++) {
+			if (request->getParam(i)->isFile()) status = 503;
+		}
+	}
+	switch (status)
+	{
+	case 200:
+		request->send(200, "text/plain", "");
+		break;
+	case 503:
+		request->send(503, "text/plain", "Too many uploads");
+		break;
+	case 507:
+		request->send(507, "text/plain", "Not enough space");
+		break;
+	default:
+		request->send(500, "text/plain", "Upload failed");
+	}
+}
+
+// Answers from the cache right away, a stale cache starts a new scan in the background
+void AsyncFSWebServer::handleScan(AsyncWebServerRequest *request) {
+	if (!_scanTime || (millis() - _scanTime > SCAN_CACHE_TTL * 1000UL)) startScan();
+	AsyncFSPooledResponse *response = new AsyncFSPooledResponse("text/json", SLAB_MEDIUM_SIZE);
+	printScanJSON(*response);
+	sendResponse(request, response);
+}
+
+void AsyncFSWebServer::startScan() {
+	if (_scanRunning) return;
+	DEBUGLOG("Starting WiFi scan\r\n");
+	_scanRunning = true;
+	WiFi.scanNetworksAsync([this](int networks) {
+		onScanDone(networks);
+	}, true);
+}
+
+void AsyncFSWebServer::onScanDone(int networks) {
+	_scanRunning = false;
+	_log.add(LOG_WIFI, LOG_DEBUG, "Scan done: %d networks", networks);
+	if (networks < 0) return;
+	_scanCount = 0;
+	for (int i = 0; i < networks; i++) {
+		strScanResult result;
+		strlcpy(result.ssid, WiFi.SSID(i).c_str(), sizeof(result.ssid));
+		memcpy(result.bssid, WiFi.BSSID(i), sizeof(result.bssid));
+		result.rssi = WiFi.RSSI(i);
+		result.channel = WiFi.channel(i);
+		result.encryption = WiFi.encryptionType(i);
+		result.hidden = WiFi.isHidden(i);
+		//one entry per ssid (hidden ones are kept apart), the strongest access point wins
+		uint8_t pos = _scanCount;
+		if (result.ssid[0]) {
+			for (uint8_t j = 0; j < _scanCount; j++) {
+				if (strcmp(_scanResults[j].ssid, result.ssid) == 0) {
+					pos = j;
+					break;
+				}
 			}
-			WiFi.scanDelete();
 		}
-		json += "]";
-		request->send(200, "text/json", json);
-		json = "";
-	});
-	on("/admin/actions/restart", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		request->send_P(200, "text/html", "Restarting...");
-		restart();
-	});
-	on("/admin/actions/factoryReset", HTTP_POST, [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		if ((request->argName(size_t(0)) == "ack") && (request->arg(size_t(0)) == "OK") && (request->args() == 1)) {
-			this->factoryReset(true);
-			request->send_P(200, "text/html", "OK");
-		} else request->send_P(500, "text/html", "BAD ARGS");
-	});
-	on("/admin/update/checkUpdate", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		this->checkUpdate();
-		request->send(200, "text/plain", "OK");
-	});
-	on("/admin/update/doUpdate", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		if (this->runUpdate()) request->send(200, "text/plain", "OK");
-		else request->send(200, "text/plain", "Check Update first!");
-	});
-	on("/admin", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		if (!this->handleFileRead("/admin.html", request))
-			request->send(404, "text/plain", "FileNotFound");
-	});
+		if (pos < _scanCount) {
+			if (_scanResults[pos].rssi >= result.rssi) continue;
+		}
+		else if (_scanCount < SCAN_MAX_RESULTS) {
+			_scanCount++;
+		}
+		else {
+			//full => replace the weakest entry (the last one) if this one is stronger
+			pos = _scanCount - 1;
+			if (_scanResults[pos].rssi >= result.rssi) continue;
+		}
+		//move up to keep the list sorted by rssi
+		while ((pos > 0) && (_scanResults[pos - 1].rssi < result.rssi)) {
+			_scanResults[pos] = _scanResults[pos - 1];
+			pos--;
+		}
+		_scanResults[pos] = result;
+	}
+	WiFi.scanDelete();
+	_scanTime = millis();
+	if (!_scanTime) _scanTime = 1;
+	_scanEventPending = true;
+}
 
-	on("/json", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		if (jsoncallback)
-			this->jsoncallback(request);
-		else
-			request->send(404, "text/plain", "FileNotFound");
-	});
-	on("/rest", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		if (restcallback)
-			this->restcallback(request);
-		else
-			request->send(404, "text/plain", "FileNotFound");
+void AsyncFSWebServer::printScanJSON(Print& out) {
+	out.print('[');
+	for (uint8_t i = 0; i < _scanCount; i++) {
+		const strScanResult& result = _scanResults[i];
+		char bssid[18];
+		snprintf(bssid, sizeof(bssid), "%02X:%02X:%02X:%02X:%02X:%02X", result.bssid[0], result.bssid[1], result.bssid[2], result.bssid[3], result.bssid[4], result.bssid[5]);
+		if (i) out.print(',');
+		out.printf("{\"rssi\":%d,\"ssid\":", result.rssi);
+		printJSONString(out, result.ssid);
+		out.printf(",\"bssid\":\"%s\",\"channel\":%u,\"secure\":%u,\"hidden\":%s}", bssid, result.channel, result.encryption, result.hidden ? "true" : "false");
+	}
+	out.print(']');
+}
+
+void AsyncFSWebServer::printJSONString(Print& out, const char* value) {
+	out.print('"');
+	for (; *value; value++) {
+		char c = *value;
+		if (c == '"' || c == '\\') {
+			out.print('\\');
+			out.print(c);
+		}
+		else if ((uint8_t)c < 0x20) out.printf("\\u%04x", c);
+		else out.print(c);
+	}
+	out.print('"');
+}
+
+void AsyncFSWebServer::handleRestart(AsyncWebServerRequest *request) {
+	request->send_P(200, "text/html", "Restarting...");
+	restart();
+}
+
+void AsyncFSWebServer::handleFactoryReset(AsyncWebServerRequest *request) {
+	if ((request->argName(size_t(0)) == "ack") && (request->arg(size_t(0)) == "OK") && (request->args() == 1)) {
+		factoryReset(true);
+		request->send_P(200, "text/html", "OK");
+	} else request->send_P(500, "text/html", "BAD ARGS");
+}
+
+void AsyncFSWebServer::handleCheckUpdate(AsyncWebServerRequest *request) {
+	checkUpdate();
+	request->send(200, "text/plain", "OK");
+}
+
+void AsyncFSWebServer::handleDoUpdate(AsyncWebServerRequest *request) {
+	if (runUpdate()) request->send(200, "text/plain", "OK");
+	else request->send(200, "text/plain", "Check Update first!");
+}
+
+void AsyncFSWebServer::handleAdminPage(AsyncWebServerRequest *request) {
+	if (!handleFileRead("/admin.html", request))
+		request->send(404, "text/plain", "FileNotFound");
+}
+
+void AsyncFSWebServer::handleJSON(AsyncWebServerRequest *request) {
+	if (jsoncallback)
+		jsoncallback(request);
+	else
+		request->send(404, "text/plain", "FileNotFound");
+}
+
+void AsyncFSWebServer::handleREST(AsyncWebServerRequest *request) {
+	if (restcallback)
+		restcallback(request);
+	else
+		request->send(404, "text/plain", "FileNotFound");
+}
+
+void AsyncFSWebServer::handlePOST(AsyncWebServerRequest *request) {
+	if (postcallback)
+		postcallback(request);
+	else
+		request->send(404, "text/plain", "FileNotFound");
+}
+
+void AsyncFSWebServer::handleForbidden(AsyncWebServerRequest *request) {
+	AsyncWebServerResponse *response = request->beginResponse(403, "text/plain", "Forbidden");
+	response->addHeader("Connection", "close");
+	response->addHeader("Access-Control-Allow-Origin", "*");
+	sendResponse(request, response);
+}
+
+void AsyncFSWebServer::handleAll(AsyncWebServerRequest *request) {
+	AsyncFSPooledResponse *response = new AsyncFSPooledResponse("text/json", 64);
+	response->printf("{\"heap\":%u, \"analog\":%d, \"gpio\":%u}", ESP.getFreeHeap(), analogRead(A0), (uint32_t)(((GPI | GPO) & 0xFFFF) | ((GP16I & 0x01) << 16)));
+	sendResponse(request, response);
+}
+
+// handler run time in us, bucket i counts requests <= bound i
+static const uint32_t metricsLatencyBounds[METRICS_LATENCY_BUCKETS - 1] = { 1000, 5000, 20000, 100000, 500000 };
+
+void AsyncFSWebServer::sampleHeap() {
+	uint32_t heap = ESP.getFreeHeap();
+	if (heap < _metricsHeapLow) _metricsHeapLow = heap;
+}
+
+void AsyncFSWebServer::recordRequest(const strRoute* route, uint32_t micros, bool authFailed) {
+	strRouteMetrics& m = _routeMetrics[route - _routes];
+	m.count++;
+	if (authFailed) {
+		m.authFailures++;
+		_metricsAuthFailures++;
+		return;
+	}
+	uint8_t bucket = 0;
+	while ((bucket < METRICS_LATENCY_BUCKETS - 1) && (micros > metricsLatencyBounds[bucket])) bucket++;
+	m.latency[bucket]++;
+	m.latencySum += micros;
+	sampleHeap();
+}
+
+const char* AsyncFSWebServer::methodName(WebRequestMethodComposite methods) {
+	switch (methods) {
+	case HTTP_GET: return "GET";
+	case HTTP_POST: return "POST";
+	case HTTP_PUT: return "PUT";
+	case HTTP_DELETE: return "DELETE";
+	case HTTP_ANY: return "ANY";
+	default: return "OTHER";
+	}
+}
+
+// one slab pool family, a line per size class
+static int metricsSlabLine(uint8_t family, char* buf, size_t size) {
+	static const char* const families[3] = { "fsws_slab_blocks_used gauge", "fsws_slab_blocks_peak gauge", "fsws_slab_fallbacks_total counter" };
+	int len = snprintf(buf, size, "# TYPE %s\n", families[family]);
+	int nameLen = strchr(families[family], ' ') - families[family];
+	for (uint8_t i = 0; (i < SLAB_POOLS) && (len < (int)size); i++) {
+		const strSlabStats& stats = slabStats(i);
+		uint32_t value = (family == 0) ? stats.used : ((family == 1) ? stats.peak : stats.fallbacks);
+		len += snprintf(buf + len, size - len, "%.*s{size=\"%u\"} %u\n", nameLen, families[family], stats.blockSize, value);
+	}
+	return (len < (int)size) ? len : size - 1;
+}
+
+// Server wide values, -1 after the last one
+int AsyncFSWebServer::metricsGlobalLine(uint8_t line, char* buf, size_t size) {
+	switch (line) {
+	case 0:
+		return snprintf(buf, size, "# TYPE fsws_uptime_seconds gauge\nfsws_uptime_seconds %u\n", millis() / 1000);
+	case 1:
+		return snprintf(buf, size, "# TYPE fsws_heap_free_bytes gauge\nfsws_heap_free_bytes %u\n", ESP.getFreeHeap());
+	case 2:
+		return snprintf(buf, size, "# TYPE fsws_heap_free_min_bytes gauge\nfsws_heap_free_min_bytes %u\n", _metricsHeapLow);
+	case 3:
+		return snprintf(buf, size, "# TYPE fsws_heap_max_block_bytes gauge\nfsws_heap_max_block_bytes %u\n", ESP.getMaxFreeBlockSize());
+	case 4:
+		return snprintf(buf, size, "# TYPE fsws_heap_fragmentation_percent gauge\nfsws_heap_fragmentation_percent %u\n", ESP.getHeapFragmentation());
+	case 5:
+		return snprintf(buf, size, "# TYPE fsws_file_requests_total counter\nfsws_file_requests_total %u\n", _metricsFileRequests);
+	case 6:
+		return snprintf(buf, size, "# TYPE fsws_file_not_modified_total counter\nfsws_file_not_modified_total %u\n", _metricsFileNotModified);
+	case 7:
+		return snprintf(buf, size, "# TYPE fsws_file_bytes_total counter\nfsws_file_bytes_total %u\n", _metricsFileBytes);
+	case 8:
+		return snprintf(buf, size, "# TYPE fsws_not_found_total counter\nfsws_not_found_total %u\n", _metricsNotFound);
+	case 9:
+		return snprintf(buf, size, "# TYPE fsws_auth_failures_total counter\nfsws_auth_failures_total %u\n", _metricsAuthFailures);
+	case 10:
+		return snprintf(buf, size, "# TYPE fsws_sse_clients gauge\nfsws_sse_clients{source=\"/events\"} %u\nfsws_sse_clients{source=\"/updEvents\"} %u\n", _evs.count(), _evsUpd.count());
+	case 11:
+		return snprintf(buf, size, "# TYPE fsws_sse_queue_avg gauge\nfsws_sse_queue_avg{source=\"/events\"} %u\nfsws_sse_queue_avg{source=\"/updEvents\"} %u\n", _evs.avgPacketsWaiting(), _evsUpd.avgPacketsWaiting());
+	case 12:
+		return snprintf(buf, size, "# TYPE fsws_ota_throughput_bytes_per_second gauge\nfsws_ota_throughput_bytes_per_second %u\n", _fwStage.throughput);
+	case 13:
+	case 14:
+	case 15:
+		return metricsSlabLine(line - 13, buf, size);
+	case 16:
+		return snprintf(buf, size, "# TYPE fsws_requests_in_flight gauge\nfsws_requests_in_flight %u\n", (uint32_t)_admitted.size());
+	case 17:
+		return snprintf(buf, size, "# TYPE fsws_requests_in_flight_peak gauge\nfsws_requests_in_flight_peak %u\n", _requestsPeak);
+	case 18:
+		return snprintf(buf, size, "# TYPE fsws_requests_rejected_total counter\nfsws_requests_rejected_total %u\n", _requestsRejected);
+	default:
+		return -1;
+	}
+}
+
+// Renders the next line (group) of /metrics into buf, false when done.
+// Per route families list all routes that were requested at least once.
+bool AsyncFSWebServer::metricsLine(strMetricsCursor& cursor, char* buf, size_t size, int& len) {
+	static const char* const families[3] = { "fsws_requests_total counter", "fsws_route_auth_failures_total counter", "fsws_request_duration_seconds histogram" };
+	len = 0;
+	if (cursor.section == 0) {
+		len = metricsGlobalLine(cursor.line++, buf, size);
+		if (len < 0) {
+			len = 0;
+			cursor.section++;
+			cursor.line = 0;
+		}
+		return true;
+	}
+	if (cursor.section > 3) return false;
+	if (cursor.route >= _routeCount) {
+		cursor.section++;
+		cursor.route = 0;
+		cursor.line = 0;
+		cursor.typeSent = false;
+		return true;
+	}
+	const strRouteMetrics& m = _routeMetrics[cursor.route];
+	if (!m.count) {
+		cursor.route++;
+		return true;
+	}
+	if (!cursor.typeSent) {
+		cursor.typeSent = true;
+		len = snprintf(buf, size, "# TYPE %s\n", families[cursor.section - 1]);
+		return true;
+	}
+	const char* path = _routes[cursor.route].path;
+	const char* method = methodName(_routes[cursor.route].methods);
+	if (cursor.section == 1) {
+		len = snprintf(buf, size, "fsws_requests_total{route=\"%s\",method=\"%s\"} %u\n", path, method, m.count);
+		cursor.route++;
+		return true;
+	}
+	if (cursor.section == 2) {
+		len = snprintf(buf, size, "fsws_route_auth_failures_total{route=\"%s\",method=\"%s\"} %u\n", path, method, m.authFailures);
+		cursor.route++;
+		return true;
+	}
+	//histogram: buckets (cumulative), sum, count
+	if (cursor.line < METRICS_LATENCY_BUCKETS) {
+		uint32_t cumulative = 0;
+		for (uint8_t i = 0; i <= cursor.line; i++) cumulative += m.latency[i];
+		char le[12];
+		if (cursor.line < METRICS_LATENCY_BUCKETS - 1) snprintf(le, sizeof(le), "%u.%03u", metricsLatencyBounds[cursor.line] / 1000000, (metricsLatencyBounds[cursor.line] / 1000) % 1000);
+		else strcpy(le, "+Inf");
+		len = snprintf(buf, size, "fsws_request_duration_seconds_bucket{route=\"%s\",method=\"%s\",le=\"%s\"} %u\n", path, method, le, cumulative);
+		cursor.line++;
+	}
+	else {
+		len = snprintf(buf, size, "fsws_request_duration_seconds_sum{route=\"%s\",method=\"%s\"} %u.%06u\n"
+			"fsws_request_duration_seconds_count{route=\"%s\",method=\"%s\"} %u\n",
+			path, method, m.latencySum / 1000000, m.latencySum % 1000000, path, method, m.count - m.authFailures);
+		cursor.line = 0;
+		cursor.route++;
+	}
+	return true;
+}
+
+void AsyncFSWebServer::handleMetrics(AsyncWebServerRequest *request) {
+	//rendered lazily like the file list, nothing is built up front
+	strMetricsCursor cursor;
+	bool done = false;
+	char line[METRICS_LINE_LEN] = ""; // copied into the callback
+	size_t lineLen = 0;
+	size_t linePos = 0;
+	AsyncWebServerResponse *response = request->beginChunkedResponse("text/plain; version=0.0.4", [this, cursor, done, line, lineLen, linePos](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+		size_t written = 0;
+		while (written < maxLen) {
+			if (linePos < lineLen) {
+				size_t n = lineLen - linePos;
+				if (n > maxLen - written) n = maxLen - written;
+				memcpy(buffer + written, line + linePos, n);
+				written += n;
+				linePos += n;
+				continue;
+			}
+			if (done) break;
+			int n;
+			done = !metricsLine(cursor, line, sizeof(line), n);
+			lineLen = (n < (int)sizeof(line)) ? n : sizeof(line) - 1;
+			linePos = 0;
+		}
+		return written;
 	});
-	on("/post", [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		if (postcallback)
-			this->postcallback(request);
-		else
-			request->send(404, "text/plain", "FileNotFound");
+	sendResponse(request, response);
+}
+
+// GET /admin/log[?since=<seq>] lists the event log, X-Log-Next tells where to continue.
+// GET /admin/log?subsystem=wifi&level=debug changes the level at runtime.
+void AsyncFSWebServer::handleLog(AsyncWebServerRequest *request) {
+	if (request->hasArg("subsystem") && request->hasArg("level")) {
+		int subsystem = EventLog::parseSubsystem(request->arg("subsystem"));
+		int level = EventLog::parseLevel(request->arg("level"));
+		if ((subsystem < 0) || (level < 0)) return request->send(400, "text/plain", "BAD ARGS");
+		_log.setLevel((enumLogSubsystem)subsystem, (enumLogLevel)level);
+		return request->send(200, "text/plain", "OK");
+	}
+	uint32_t seq = _log.first();
+	if (request->hasArg("since")) {
+		uint32_t since = strtoul(request->arg("since").c_str(), NULL, 10);
+		if (since > seq) seq = since;
+	}
+	//entries are formatted one at a time while sending
+	uint32_t end = _log.next();
+	char line[EVENTLOG_LINE_LEN];
+	size_t lineLen = 0;
+	size_t linePos = 0;
+	AsyncWebServerResponse *response = request->beginChunkedResponse("text/plain", [this, seq, end, line, lineLen, linePos](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+		size_t written = 0;
+		while (written < maxLen) {
+			if (linePos < lineLen) {
+				size_t n = lineLen - linePos;
+				if (n > maxLen - written) n = maxLen - written;
+				memcpy(buffer + written, line + linePos, n);
+				written += n;
+				linePos += n;
+				continue;
+			}
+			if (seq >= end) break;
+			//entries overwritten meanwhile are skipped
+			if (seq < _log.first()) seq = _log.first();
+			lineLen = _log.format(seq++, line, sizeof(line));
+			linePos = 0;
+		}
+		return written;
 	});
+	response->addHeader("X-Log-Next", String(end));
+	sendResponse(request, response);
+}
+
+void AsyncFSWebServer::serverInit() {
+	DEBUGLOG(__FUNCTION__);
+	DEBUGLOG("\r\n");
+	//SERVER INIT
+	//sort route table by hash once, requests are dispatched by binary search
+	_routeMetrics.resize(_routeCount);
+	_routeOrder.clear();
+	for (uint8_t i = 0; i < _routeCount; i++) {
+		size_t pos = _routeOrder.size();
+		while (pos > 0 && _routes[_routeOrder[pos - 1]].hash > _routes[i].hash) pos--;
+		_routeOrder.insert(_routeOrder.begin() + pos, i);
+	}
+	addHandler(&_admissionHandler); //must stay the first handler
+	addHandler(&_routeHandler);
 
 	//called when the url is not defined here
 	//use it to load content from SPIFFS
 	onNotFound([this](AsyncWebServerRequest *request) {
-		DEBUGLOG("Not found: %s\r\n", request->url().c_str());
-		if (!this->checkAuth(request))
+		_log.add(LOG_HTTP, LOG_DEBUG, "Not found: %s", 0, 0, request->url().c_str());
+		enumAuthResult auth = this->checkAuth(request);
+		if (auth == AUTH_DENIED) {
+			_metricsAuthFailures++;
 			return request->requestAuthentication();
-		AsyncWebServerResponse *response = request->beginResponse(200);
-		response->addHeader("Connection", "close");
-		response->addHeader("Access-Control-Allow-Origin", "*");
-		if (!this->handleFileRead(request->url(), request))
+		}
+		_sessionRequest = (auth == AUTH_NEW_SESSION) ? request : NULL;
+		if (!this->handleFileRead(request->url(), request)) {
+			_metricsNotFound++;
 			request->send(404, "text/plain", "FileNotFound");
-		delete response; // Free up memory!
-	});
-
-#ifdef HIDE_SECRET
-	on(SECRET_FILE, HTTP_GET, [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		AsyncWebServerResponse *response = request->beginResponse(403, "text/plain", "Forbidden");
-		response->addHeader("Connection", "close");
-		response->addHeader("Access-Control-Allow-Origin", "*");
-		request->send(response);
-	});
-#endif // HIDE_SECRET
-
-#ifdef HIDE_CONFIG
-	on(CONFIG_FILE, HTTP_GET, [this](AsyncWebServerRequest *request) {
-		if (!this->checkAuth(request))
-			return request->requestAuthentication();
-		AsyncWebServerResponse *response = request->beginResponse(403, "text/plain", "Forbidden");
-		response->addHeader("Connection", "close");
-		response->addHeader("Access-Control-Allow-Origin", "*");
-		request->send(response);
+		}
+		_sessionRequest = NULL;
 	});
-#endif // HIDE_CONFIG
 
-	//get heap status, analog input value and all GPIO statuses in one json call
-	on("/all", HTTP_GET, [](AsyncWebServerRequest *request) {
-		String json = "{";
-		json += "\"heap\":" + String(ESP.getFreeHeap());
-		json += ", \"analog\":" + String(analogRead(A0));
-		json += ", \"gpio\":" + String((uint32_t)(((GPI | GPO) & 0xFFFF) | ((GP16I & 0x01) << 16)));
-		json += "}";
-		request->send(200, "text/json", json);
-		json = String();
+	_evs.onConnect([this](AsyncEventSourceClient* client) {
+		_log.add(LOG_HTTP, LOG_DEBUG, "SSE client %s connected", 0, 0, client->client()->remoteIP().toString().c_str());
+		_sseTimeFull = true;
 	});
 
-#ifndef RELEASE
-	_evs.onConnect([](AsyncEventSourceClient* client) {
-		DEBUGLOG("Event source client connected from %s\r\n", client->client()->remoteIP().toString().c_str());
-	});
-#endif //	!RELEASE
-
 	_evsUpd.onConnect([this](AsyncEventSourceClient* client) {
 		_evsUpd.send("", "rdy", 0, 500);
 	});
@@ -1589,14 +2840,102 @@ void AsyncFSWebServer::serverInit() {
 	DEBUGLOG("HTTP server started\r\n");
 }
 
-bool AsyncFSWebServer::checkAuth(AsyncWebServerRequest *request) {
+enumAuthResult AsyncFSWebServer::checkAuth(AsyncWebServerRequest *request) {
 	if (!_httpAuth.auth) {
-		return true;
+		return AUTH_GRANTED;
 	}
-	else {
-		return request->authenticate(_httpAuth.wwwUsername.c_str(), _httpAuth.wwwPassword.c_str());
+	//valid session cookie => skip Basic/Digest verification
+	if (findSession(request) >= 0) {
+		return AUTH_GRANTED;
+	}
+	if (!request->authenticate(_httpAuth.wwwUsername.c_str(), _httpAuth.wwwPassword.c_str())) {
+		return AUTH_DENIED;
+	}
+	//session is created when the response can carry the cookie (see sendResponse)
+	return AUTH_NEW_SESSION;
+}
+
+int AsyncFSWebServer::findSession(AsyncWebServerRequest *request) {
+	AsyncWebHeader* cookie = request->getHeader("Cookie");
+	if (!cookie) return -1;
+	//name must start the header or follow a ";" separator, "XFSWSID=" is another cookie
+	const char* header = cookie->value().c_str();
+	const char* value = header;
+	while ((value = strstr(value, AUTH_SESSION_COOKIE "="))) {
+		if ((value == header) || ((value - header >= 2) && (value[-1] == ' ') && (value[-2] == ';')) || (value[-1] == ';')) break;
+		value++;
+	}
+	if (!value) return -1;
+	value += sizeof(AUTH_SESSION_COOKIE);
+	uint8_t token[AUTH_SESSION_TOKEN_LEN];
+	for (uint8_t i = 0; i < AUTH_SESSION_TOKEN_LEN; i++) {
+		if (!isxdigit(value[2 * i]) || !isxdigit(value[2 * i + 1])) return -1;
+		token[i] = (hex2int(value[2 * i]) << 4) | hex2int(value[2 * i + 1]);
+	}
+	uint32_t ms = millis();
+	int found = -1;
+	for (uint8_t s = 0; s < AUTH_SESSION_SLOTS; s++) {
+		if (!_sessions[s].used) continue;
+		if ((int32_t)(_sessions[s].expires - ms) <= 0) {
+			_sessions[s].used = false;
+			continue;
+		}
+		//constant time compare, no early exit on the first differing byte
+		uint8_t diff = 0;
+		for (uint8_t i = 0; i < AUTH_SESSION_TOKEN_LEN; i++) diff |= _sessions[s].token[i] ^ token[i];
+		if (diff == 0) found = s;
+	}
+	if (found >= 0) {
+		_sessions[found].lastUsed = ms;
+		_sessions[found].expires = ms + AUTH_SESSION_TTL * 1000UL;
 	}
+	return found;
+}
 
+// Creates a session in a free or the least recently used slot
+int AsyncFSWebServer::createSession() {
+	uint32_t ms = millis();
+	uint8_t slot = 0;
+	for (uint8_t s = 0; s < AUTH_SESSION_SLOTS; s++) {
+		if (!_sessions[s].used) {
+			slot = s;
+			break;
+		}
+		if ((ms - _sessions[s].lastUsed) > (ms - _sessions[slot].lastUsed)) slot = s;
+	}
+	for (uint8_t i = 0; i < AUTH_SESSION_TOKEN_LEN; i += 4) {
+		uint32_t rnd = RANDOM_REG32;
+		memcpy(&_sessions[slot].token[i], &rnd, 4);
+	}
+	_sessions[slot].used = true;
+	_sessions[slot].lastUsed = ms;
+	_sessions[slot].expires = ms + AUTH_SESSION_TTL * 1000UL;
+	return slot;
+}
+
+void AsyncFSWebServer::clearSessions() {
+	for (uint8_t s = 0; s < AUTH_SESSION_SLOTS; s++) _sessions[s].used = false;
+	_sessionRequest = NULL;
+}
+
+void AsyncFSWebServer::addSessionCookie(AsyncWebServerRequest *request, AsyncWebServerResponse *response) {
+	if (!request || (request != _sessionRequest)) return;
+	//one cookie per request, also if the handler sends more than once
+	_sessionRequest = NULL;
+	int slot = createSession();
+	char cookie[sizeof(AUTH_SESSION_COOKIE) + 2 * AUTH_SESSION_TOKEN_LEN + 64];
+	int len = snprintf(cookie, sizeof(cookie), AUTH_SESSION_COOKIE "=");
+	for (uint8_t i = 0; i < AUTH_SESSION_TOKEN_LEN; i++) {
+		cookie[len++] = int2hex(_sessions[slot].token[i] >> 4);
+		cookie[len++] = int2hex(_sessions[slot].token[i] & 0x0F);
+	}
+	snprintf(cookie + len, sizeof(cookie) - len, "; Path=/; Max-Age=%u; HttpOnly; SameSite=Strict", AUTH_SESSION_TTL);
+	response->addHeader("Set-Cookie", cookie);
+}
+
+void AsyncFSWebServer::sendResponse(AsyncWebServerRequest *request, AsyncWebServerResponse *response) {
+	addSessionCookie(request, response);
+	request->send(response);
 }
 
 const char* AsyncFSWebServer::getHostName() {
@@ -1604,6 +2943,8 @@ const char* AsyncFSWebServer::getHostName() {
 }
 
 bool AsyncFSWebServer::factoryReset(bool all) {
+	//drop pending settings, handle() or the restart would write the record again
+	_configDirty = 0;
 	//Delete all json Files
 	if (all) {
 		Dir dir = _fs->openDir("/");
@@ -1611,13 +2952,26 @@ bool AsyncFSWebServer::factoryReset(bool all) {
 			File entry = dir.openFile("r");
 			String filename = String(entry.name());
 			entry.close();
-			if (filename.endsWith(".json")) _fs->remove(filename);
+			if (filename.endsWith(".json")) {
+				_fs->remove(filename);
+				updateAssetIndex(filename);
+			}
 			filename = "";
 		}
+		_fs->remove("/" CONFIG_RECORD_FILE);
+		_fs->remove("/" CONFIG_RECORD_FILE ".tmp");
+		_fs->remove("/" WIFI_CACHE_FILE);
+		return true;
 	}
 	else {
-		//delete Lib json files only
-		return _ConfigFileHandler.deleteConfigFile(CONFIG_FILE) && _ConfigFileHandler.deleteConfigFile(SECRET_FILE);
+		//delete Lib config files only
+		_fs->remove("/" CONFIG_RECORD_FILE);
+		_fs->remove("/" CONFIG_RECORD_FILE ".tmp");
+		_fs->remove("/" WIFI_CACHE_FILE);
+		bool okay = _ConfigFileHandler.deleteConfigFile(CONFIG_FILE) && _ConfigFileHandler.deleteConfigFile(SECRET_FILE);
+		updateAssetIndex("/" CONFIG_FILE);
+		updateAssetIndex("/" SECRET_FILE);
+		return okay;
 	}
 }
 
@@ -1661,6 +3015,7 @@ void AsyncFSWebServer::restartESP(void* arg) {
 
 void AsyncFSWebServer::s_restartESP(void* arg) {
 	AsyncFSWebServer* self = reinterpret_cast<AsyncFSWebServer*>(arg);
+	self->flushConfig();
 	self->_fs->end();
 	DEBUGLOG("Restarting...\r\n");
 	delay(200);
@@ -1704,41 +3059,28 @@ char AsyncFSWebServer::int2hex(unsigned char c) {
 	return('0');
 }
 
-// (based on https://code.google.com/p/avr-netino/)
-String AsyncFSWebServer::decodeURIComponent(String input) {
-	char c;
-	String ret = "";
-
-	for (byte t = 0; t < input.length(); t++) {
-		c = input[t];
-		if (c == '+') c = ' ';
-		if (c == '%') {
-			t++;
-			c = input[t];
-			t++;
-			c = (hex2int(c) << 4) | hex2int(input[t]);
-		}
-		ret.concat(c);
-	}
+String AsyncFSWebServer::decodeURIComponent(const String& input) {
+	String ret = input;
+	//decoding never grows => in place in the copy
+	char* buf = const_cast<char*>(ret.c_str());
+	ret.remove(uriDecode(buf, ret.length(), buf));
 	return ret;
 }
 
-// accepted Characters: A-Z a-z 0-9 - _ . ! ~ * ' ( )
-String AsyncFSWebServer::encodeURIComponent(String input) {
-	char c;
-	String ret = "";
-
-	for (byte t = 0; t < input.length(); t++) {
-		c = input[t];
-		//accepted?
-		if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '!' || c == '~' || c == '*' || c == 0x27 || c == '(' || c == ')') {
-			ret.concat(c);
-			continue;
-		}
-		//not accepted => encode
-		ret.concat('%');
-		ret.concat(int2hex((unsigned char)c >> 4));
-		ret.concat(int2hex((unsigned char)c & 0x0F));
+String AsyncFSWebServer::encodeURIComponent(const String& input) {
+	String ret;
+	if (!ret.reserve(uriEncodedLength(input.c_str(), input.length()))) return ret;
+	//encode in blocks, the reserved buffer never grows
+	char block[3 * 16 + 1];
+	const char* in = input.c_str();
+	size_t left = input.length();
+	while (left) {
+		size_t n = (left < 16) ? left : 16;
+		size_t o = uriEncode(in, n, block);
+		block[o] = 0;
+		ret.concat(block);
+		in += n;
+		left -= n;
 	}
 	return ret;
 }
@@ -21,6 +21,14 @@
 #include <Ticker.h>
 #include <ArduinoOTA.h>
 #include <JSONtoSPIFFS.h>
+#include "HTTPResponseParser.h"
+#include "GzipWriter.h"
+#include "EventLog.h"
+#include "SlabPool.h"
+#include "URICodec.h"
+#include <vector>
+#include <new>
+#include <algorithm>
 
 #define RELEASE  // Comment to enable debug output
 
@@ -36,8 +44,61 @@
 
 #define HIDE_SECRET
 //#define HIDE_CONFIG
+#define FILELIST_MTIME // Comment out for ESP8266 cores without Dir::fileTime() (< 2.6.0), ETags then only depend on the size
+
+#define ASSET_INDEX_MAX 64 // files with a known content type kept in the static asset index, others are probed per request
+#define ASSET_PATH_LEN 32 // SPIFFS_OBJ_NAME_LEN, longer paths are not indexed
+#define ASSET_ETAG_LEN 28
+
+#define TIMESTR_LEN 24 // buffer size for formatTime() and friends
+
+#define FW_UPDATE_COMPRESSED // Comment out for ESP8266 cores < 2.7.0 (eboot cannot inflate gzip images)
+#define FW_RESUME_ATTEMPTS 5 // reconnects after the download was interrupted
+#define FW_RESUME_DELAY 3 // seconds, multiplied by the attempt number
+#define FW_STAGE_SECTOR 4096 // OTA data is staged in two buffers of one flash sector each
+#ifdef TCP_WND
+#define FW_STAGE_TCP_WND TCP_WND
+#else
+#define FW_STAGE_TCP_WND 5840
+#endif
+
+#define AUTH_SESSION_SLOTS 4 // logins remembered by session cookie (least recently used is replaced)
+#define AUTH_SESSION_TTL 1800 // seconds without request until a session expires
+#define AUTH_SESSION_TOKEN_LEN 16 // random bytes per token
+#define AUTH_SESSION_COOKIE "FSWSID"
+
+#define SSE_BUF_LEN 192 // rendered timeDate/UpdData event
+#define SSE_MAX_WAITING 4 // timeDate ticks are merged while clients have more messages queued (average)
+#define SSE_TIME_FIELDS 5
+
+#define METRICS_LATENCY_BUCKETS 6 // handler time histogram: <=1, 5, 20, 100, 500 ms, more
+#define METRICS_LINE_LEN 192 // longest rendered /metrics line group
+
+#define UPLOAD_MAX_CONCURRENT 2 // parallel /edit uploads, more are answered with 503
+#define UPLOAD_BATCH_SIZE 1024 // bytes collected per upload before writing (multiple of the SPIFFS page size)
+//#define UPLOAD_GZIP // Compress text uploads by default (can be switched with setGzipUploads())
+
+#define ROUTE_PENDING 4 // matched routes remembered from canHandle() until handleRequest() (after the body)
+
+#define ADMISSION_MAX_REQUESTS 8 // requests in flight, more are answered with 503 (event streams and websockets are not counted)
+#define ADMISSION_RESERVED 1 // slots only /admin and /edit requests may take, the rest must exceed a browser's 6 connections per host
+#define ADMISSION_RETRY_AFTER "2" // seconds, sent with the 503
+
 #define CONFIG_FILE "config_WebServerLib.json"
 #define SECRET_FILE "config_HTTPAuth.json"
+#define CONFIG_RECORD_FILE "config_WebServerLib.bin" // binary copy of config and secret, the JSON files are only imported
+#define CONFIG_RECORD_MAGIC 0x43575346 // "FSWC"
+#define CONFIG_RECORD_VERSION 1
+#define WIFI_CACHE_FILE "wifi_WebServerLib.bin" // BSSID, channel and DHCP lease of the last connection
+#define WIFI_CACHE_MAGIC 0x49575346 // "FSWI"
+#define WIFI_FAST_TIMEOUT 5 // seconds for the directed connect before falling back to scan + DHCP
+#define WIFI_LEASE_USES 10 // boots with the cached lease before DHCP is asked again
+#define SCAN_MAX_RESULTS 16 // strongest networks kept from a scan
+#define SCAN_CACHE_TTL 30 // seconds a scan result is served before the next request starts a new scan
+#define CONFIG_SAVE_DELAY 3000 // ms, changes within this window are written together by handle()
+#define CONFIG_DIRTY_CONFIG 0x01
+#define CONFIG_DIRTY_AUTH 0x02
+#define CONFIG_DIRTY_FIRMWARE 0x04
 
 #define JSON_CALLBACK_SIGNATURE std::function<void(AsyncWebServerRequest *request)> jsoncallback
 #define REST_CALLBACK_SIGNATURE std::function<void(AsyncWebServerRequest *request)> restcallback
@@ -115,10 +176,209 @@ typedef struct {
 	uint32_t actSize = 0;
 	bool updSpiffs = false;
 	bool rcvdSpiffs = false;
+	bool compressed = false; // server sent a gzip compressed sketch
+	bool resuming = false; // reconnecting to continue an interrupted download
+	uint8_t resumeAttempts = 0;
+	uint32_t rangeStart = 0; // from Content-Range of a resumed download
+	String resumeMD5 = "";
 	bool startFWupdate = false;
 } strFirmware;
 
+// Fixed layout image of strConfig, strHTTPAuth and the firmware server,
+// read and written in one piece. Longer strings are truncated.
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t length; // sizeof(strConfigRecord)
+	char ssid[33];
+	char password[65];
+	uint32_t ip;
+	uint32_t netmask;
+	uint32_t gateway;
+	uint32_t dns;
+	int32_t updateNTPTimeEvery;
+	int32_t timezone;
+	uint8_t dhcp;
+	uint8_t daylight;
+	uint8_t startAP;
+	uint8_t auth;
+	char ntpServerName[65];
+	char deviceName[33];
+	char wwwUsername[33];
+	char wwwPassword[65];
+	char firmwareServer[65];
+	char firmwarePath[129];
+	uint32_t crc; // crc32Update() over everything before this field
+} strConfigRecord;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t netId; // crc32Update() of ssid and password this entry belongs to
+	uint8_t bssid[6];
+	uint8_t channel;
+	uint8_t leaseUses; // boots left with the cached lease, 0 => DHCP
+	uint32_t ip;
+	uint32_t gateway;
+	uint32_t netmask;
+	uint32_t dns;
+	uint32_t crc; // crc32Update() over everything before this field
+} strWiFiCache;
+
+typedef struct {
+	char ssid[33];
+	uint8_t bssid[6];
+	int8_t rssi;
+	uint8_t channel;
+	uint8_t encryption;
+	bool hidden;
+} strScanResult;
+
+typedef struct {
+	uint64_t key; // lower case extension packed by mimeKey()
+	const char* type;
+} strMimeType;
+
+typedef struct {
+	uint8_t* buf[2] = { NULL, NULL };
+	size_t fill[2] = { 0, 0 };
+	bool full[2] = { false, false }; // waiting to be written by handle()
+	uint8_t active = 0; // buffer currently being filled
+	uint32_t received = 0; // body bytes received, >= actSize
+	size_t unacked = 0; // received bytes not yet acked to TCP
+	uint32_t startTime = 0;
+	uint32_t throughput = 0; // bytes/s of the last update
+	bool clientClosed = false; // server closed while data was still staged
+} strFlashStage;
+
+typedef enum {
+	AUTH_DENIED,
+	AUTH_GRANTED, // auth disabled or valid session cookie
+	AUTH_NEW_SESSION // credentials verified, the response should carry a session cookie
+} enumAuthResult;
+
+typedef struct {
+	uint8_t token[AUTH_SESSION_TOKEN_LEN];
+	uint32_t expires; // millis()
+	uint32_t lastUsed; // millis()
+	bool used = false;
+} strAuthSession;
+
+typedef struct {
+	String prefix;
+	uint32_t maxAge; // seconds, 0 => always revalidate
+} strCachePolicy;
+
+typedef struct {
+	char path[ASSET_PATH_LEN];
+	bool gz; // path.gz exists and is served instead
+	uint32_t size; // size of the served variant
+	uint32_t mtime; // of the served variant, 0 without FILELIST_MTIME
+	const char* contentType;
+} strAssetEntry;
+
+class AsyncFSWebServer;
+typedef void (AsyncFSWebServer::*RouteHandler)(AsyncWebServerRequest *request);
+
+typedef struct {
+	const char* path;
+	uint32_t hash; // routeHash(path)
+	WebRequestMethodComposite methods;
+	bool auth;
+	bool prefix; // also handles path + "/...", like on() did
+	RouteHandler handler;
+} strRoute;
+
+typedef struct {
+	AsyncWebServerRequest* request; // NULL => free
+	const strRoute* route;
+} strPendingRoute;
+
+typedef struct {
+	AsyncWebServerRequest* request; // only compared, it may be gone already
+	uint32_t remoteIP; // the connection, lwIP keeps it listed until it is closed
+	uint16_t remotePort;
+	uint16_t localPort;
+} strAdmissionSlot;
+
+typedef struct {
+	uint32_t count = 0;
+	uint32_t authFailures = 0;
+	uint32_t latency[METRICS_LATENCY_BUCKETS] = {}; // not cumulative
+	uint32_t latencySum = 0; // us
+} strRouteMetrics;
+
+typedef struct {
+	uint8_t section = 0;
+	uint8_t route = 0;
+	uint8_t line = 0; // line within the section or route
+	bool typeSent = false;
+} strMetricsCursor;
+
+// Single handler dispatching all library URLs through the route table
+class AsyncFSRouteHandler : public AsyncWebHandler {
+public:
+	AsyncFSRouteHandler(AsyncFSWebServer* server) : _server(server) {}
+	virtual bool canHandle(AsyncWebServerRequest *request) override;
+	virtual void handleRequest(AsyncWebServerRequest *request) override;
+	virtual void handleUpload(AsyncWebServerRequest *request, const String& filename, size_t index, uint8_t *data, size_t len, bool final) override;
+	virtual bool isRequestHandlerTrivial() override { return false; }
+private:
+	AsyncFSWebServer* _server;
+	strPendingRoute _pending[ROUTE_PENDING] = {};
+	uint8_t _nextPending = 0;
+	const strRoute* takeRoute(AsyncWebServerRequest *request);
+};
+
+// First handler of the server: counts the requests in flight and takes
+// the ones over the limit, before anything else is parsed or allocated
+class AsyncFSAdmissionHandler : public AsyncWebHandler {
+public:
+	AsyncFSAdmissionHandler(AsyncFSWebServer* server) : _server(server) {}
+	virtual bool canHandle(AsyncWebServerRequest *request) override; // true => reject
+	virtual void handleRequest(AsyncWebServerRequest *request) override;
+	virtual bool isRequestHandlerTrivial() override { return true; }
+private:
+	AsyncFSWebServer* _server;
+};
+
+// State of one running /edit upload. Data is collected in UPLOAD_BATCH_SIZE
+// blocks before it goes to the file, the gzip compressor writes through it too.
+class AsyncFSUpload : public Print {
+public:
+	AsyncWebServerRequest* request = NULL; // NULL => slot is free
+	File file;
+	GzipWriter* gzWriter = NULL;
+	String plainPath; // uncompressed copy to remove once the .gz file is complete
+	size_t size = 0;
+	int status = 200; // sent by handleUploadDone()
+
+	bool begin(AsyncWebServerRequest* req);
+	void end();
+	bool flushBatch();
+	virtual size_t write(uint8_t c) override;
+	virtual size_t write(const uint8_t* data, size_t len) override;
+private:
+	uint8_t* _batch = NULL;
+	size_t _batchFill = 0;
+};
+
+// Response body rendered into slab blocks instead of the growing cbuf of
+// AsyncResponseStream, the content length follows every write
+class AsyncFSPooledResponse : public AsyncAbstractResponse, public Print {
+public:
+	AsyncFSPooledResponse(const String& contentType, size_t sizeHint = 0);
+	virtual size_t write(uint8_t c) override;
+	virtual size_t write(const uint8_t* data, size_t len) override;
+	virtual bool _sourceValid() const override { return true; }
+	virtual size_t _fillBuffer(uint8_t* buf, size_t maxLen) override;
+private:
+	PooledBuffer _content;
+	size_t _readPos;
+};
+
 class AsyncFSWebServer : public AsyncWebServer {
+	friend class AsyncFSRouteHandler;
+	friend class AsyncFSAdmissionHandler;
 public:
 	AsyncFSWebServer(uint16_t port);
 	void begin(FS* fs);
@@ -128,11 +388,23 @@ public:
 	void checkUpdate();
 	bool runUpdate();
 
+	void updateAssetIndex(const String& path); // call after the sketch changed a file the server delivers
+	void addContentType(const char* extension, const char* contentType); // both must stay valid (use literals)
+	const char* getContentType(const String& filename) const;
+	void setCacheControl(const String& pathPrefix, uint32_t maxAge); // longest matching prefix wins
+	void setGzipUploads(bool enable); // html/css/js/json uploads are stored as <name>.gz
+	void setMaxRequests(uint8_t maxRequests); // in flight, ADMISSION_RESERVED of them are kept for /admin and /edit
+
 	void setModelName(String s);
 	void setVersionString(String s);
 
 	bool factoryReset(bool all);
+	bool flushConfig(); // writes pending changes now, e.g. before a restart
+	bool exportConfigJSON(); // writes the current settings to CONFIG_FILE and SECRET_FILE
+	EventLog& getLog() { return _log; } // the sketch may add its own entries
+	uint32_t getWiFiConnectTime(); // ms from configureWifi() to IP, 0 while not connected
 	void restart();
+	void sendResponse(AsyncWebServerRequest *request, AsyncWebServerResponse *response); // use in the JSON/REST/POST callbacks, adds a new session cookie
 
 	void setJSONCallback(JSON_CALLBACK_SIGNATURE);
 	void setRESTCallback(REST_CALLBACK_SIGNATURE);
@@ -163,19 +435,35 @@ protected:
 
 	JSONtoSPIFFS _ConfigFileHandler;
 
-	WiFiEventHandler onStationModeConnectedHandler, onStationModeDisconnectedHandler, onSoftAPModeStationConnectedHandler, onSoftAPModeStationDisconnectedHandler;
+	WiFiEventHandler onStationModeConnectedHandler, onStationModeDisconnectedHandler, onStationModeGotIPHandler, onSoftAPModeStationConnectedHandler, onSoftAPModeStationDisconnectedHandler;
 	
 	AsyncEventSource _evs = AsyncEventSource("/events");
 	AsyncEventSource _evsUpd = AsyncEventSource("/updEvents");
 	AsyncClient* _asyncClient = NULL;
 
 	void sendTimeData();
+	char _sseBuf[SSE_BUF_LEN];
+	char _sseTimeSent[SSE_TIME_FIELDS][TIMESTR_LEN]; // last published timeDate values
+	bool _sseTimeFull = true; // next timeDate event carries all fields
+	char _updState[8]; // latest "state" for /updEvents, sent from handle()
+	bool _updStatePending = false;
+	bool _updDataPending = false;
+	void publishUpdateState(const char* state);
+	void flushEvents();
 	bool load_config();
 	void defaultConfig();
 	bool save_config();
 	bool save_startAP(bool value);
 	bool loadHTTPAuth();
 	bool saveHTTPAuth();
+	uint8_t _configDirty = 0; // CONFIG_DIRTY_* of changes not written yet
+	uint32_t _configDirtySince = 0;
+	void markConfigDirty(uint8_t what);
+	bool readConfigRecord(const char* path, strConfigRecord& rec); // false if missing or damaged
+	bool loadConfigRecord();
+	bool saveConfigRecord();
+	bool saveConfigJSON();
+	bool saveHTTPAuthJSON();
 	void configureWifiAP();
 	void configureWifi();
 	void configureOTA(String password);
@@ -185,20 +473,129 @@ protected:
 	int _WiFiAPConnectedClients;
 	void onWiFiConnected(WiFiEventStationModeConnected data);
 	void onWiFiDisconnected(WiFiEventStationModeDisconnected data);
+	void onWiFiGotIP(WiFiEventStationModeGotIP data);
 	void onWiFiAPClientConnected(WiFiEventSoftAPModeStationConnected data);
 	void onWiFiAPClientDisconnected(WiFiEventSoftAPModeStationDisconnected data);
 
 	Ticker _secondTk;
 	static void s_secondTick(void* arg);
 
+	strWiFiCache _wifiCache;
+	bool _wifiFast = false; // directed connect with the cached BSSID/channel running
+	bool _wifiFastLease = false; // ... using the cached lease as static config
+	bool _wifiFallbackPending = false;
+	bool _wifiCachePending = false; // connection data changed, written by handle()
+	uint32_t _wifiConnectStart = 0;
+	uint32_t _wifiConnectTime = 0;
+	Ticker _wifiFastTk;
+	static void s_wifiFastTimeout(void* arg);
+	strScanResult _scanResults[SCAN_MAX_RESULTS]; // sorted by rssi, one entry per ssid
+	uint8_t _scanCount = 0;
+	uint32_t _scanTime = 0; // millis() of the last completed scan, 0 => none yet
+	bool _scanRunning = false;
+	bool _scanEventPending = false; // push the new results to /events from handle()
+	void startScan();
+	void onScanDone(int networks);
+	void printScanJSON(Print& out);
+	static void printJSONString(Print& out, const char* value);
+	uint32_t wifiNetId();
+	bool loadWiFiCache();
+	bool saveWiFiCache();
+	void connectWifiFallback();
+
 	String getMacAddress();
 
-	bool checkAuth(AsyncWebServerRequest *request);
+	std::vector<strMimeType> _mimeTypes; // registered by the sketch, checked before the built-in table
+	std::vector<strCachePolicy> _cachePolicies;
+	std::vector<strAssetEntry> _assetIndex; // sorted by path
+	void buildAssetIndex();
+	bool isIndexable(const String& path) const;
+	strAssetEntry* findAsset(const String& path);
+	bool probeAsset(const String& path, strAssetEntry& entry);
+	bool statAsset(const String& path, strAssetEntry& entry);
+	bool refreshAsset(const String& path, strAssetEntry& probed);
+	static void formatETag(const strAssetEntry& entry, char* buf, size_t size);
+	const char* findContentType(const char* filename, size_t len) const; // NULL if the extension is unknown
+	uint32_t getCacheMaxAge(const String& path);
+
+#ifdef UPLOAD_GZIP
+	bool _gzipUploads = true;
+#else
+	bool _gzipUploads = false;
+#endif
+	static bool isCompressible(const String& filename);
+
+	AsyncFSUpload _uploads[UPLOAD_MAX_CONCURRENT];
+	AsyncFSUpload* findUpload(AsyncWebServerRequest *request);
+	AsyncFSUpload* openUpload(AsyncWebServerRequest *request);
+	void startUploadFile(AsyncFSUpload& upload, const String& filename);
+	void finishUploadFile(AsyncFSUpload& upload);
+	void releaseUpload(AsyncWebServerRequest *request);
+
+	static const strRoute _routes[];
+	static const size_t _routeCount;
+	std::vector<uint8_t> _routeOrder; // indices into _routes, sorted by hash
+	std::vector<strRouteMetrics> _routeMetrics; // same order as _routes
+
+	//counters are plain increments, /metrics renders them line by line
+	uint32_t _metricsFileRequests = 0;
+	uint32_t _metricsFileNotModified = 0;
+	uint32_t _metricsFileBytes = 0;
+	uint32_t _metricsNotFound = 0;
+	uint32_t _metricsAuthFailures = 0;
+	uint32_t _metricsHeapLow = UINT32_MAX;
+	void sampleHeap();
+	void recordRequest(const strRoute* route, uint32_t micros, bool authFailed);
+	int metricsGlobalLine(uint8_t line, char* buf, size_t size);
+	bool metricsLine(strMetricsCursor& cursor, char* buf, size_t size, int& len);
+	static const char* methodName(WebRequestMethodComposite methods);
+	void handleMetrics(AsyncWebServerRequest *request);
+
+	EventLog _log;
+	void handleLog(AsyncWebServerRequest *request);
+	AsyncFSAdmissionHandler _admissionHandler = AsyncFSAdmissionHandler(this);
+	uint8_t _maxRequests = ADMISSION_MAX_REQUESTS;
+	std::vector<strAdmissionSlot> _admitted; // one per request in flight
+	uint8_t _requestsPeak = 0;
+	uint32_t _requestsRejected = 0;
+	bool admitRequest(AsyncWebServerRequest *request);
+	void expireAdmissions();
+	AsyncFSRouteHandler _routeHandler = AsyncFSRouteHandler(this);
+	const strRoute* findRoute(AsyncWebServerRequest *request);
+	const strRoute* lookupRoute(const char* path, size_t len, WebRequestMethodComposite method, bool prefix);
+	void handleEditPage(AsyncWebServerRequest *request);
+	void handleUploadDone(AsyncWebServerRequest *request);
+	void handleScan(AsyncWebServerRequest *request);
+	void handleRestart(AsyncWebServerRequest *request);
+	void handleFactoryReset(AsyncWebServerRequest *request);
+	void handleCheckUpdate(AsyncWebServerRequest *request);
+	void handleDoUpdate(AsyncWebServerRequest *request);
+	void handleAdminPage(AsyncWebServerRequest *request);
+	void handleJSON(AsyncWebServerRequest *request);
+	void handleREST(AsyncWebServerRequest *request);
+	void handlePOST(AsyncWebServerRequest *request);
+	void handleForbidden(AsyncWebServerRequest *request);
+	void handleAll(AsyncWebServerRequest *request);
+
+	enumAuthResult checkAuth(AsyncWebServerRequest *request);
+	strAuthSession _sessions[AUTH_SESSION_SLOTS];
+	AsyncWebServerRequest* _sessionRequest = NULL; // AUTH_NEW_SESSION request being handled, its response gets the cookie
+	int findSession(AsyncWebServerRequest *request);
+	int createSession();
+	void clearSessions();
+	void addSessionCookie(AsyncWebServerRequest *request, AsyncWebServerResponse *response);
 	void handleFileList(AsyncWebServerRequest *request);
 	bool handleFileRead(String path, AsyncWebServerRequest *request);
 	void handleFileCreate(AsyncWebServerRequest *request);
 	void handleFileDelete(AsyncWebServerRequest *request);
 	void handleFileUpload(AsyncWebServerRequest *request, String filename, size_t index, uint8_t *data, size_t len, bool final);
+	static void printAjaxValue(Print& out, const char* key, const char* value, const char* type);
+	static void printAjaxEncoded(Print& out, const char* key, const char* value, const char* type);
+	static void printAjaxIP(Print& out, const char* key, const IPAddress& ip, const char* type);
+	static const char* formatTime(char* buf, time_t moment);
+	static const char* formatDate(char* buf, time_t moment);
+	static const char* formatTimeDate(char* buf, time_t moment);
+	static const char* formatUptime(char* buf, time_t uptime);
 	void send_network_configuration_values_html(AsyncWebServerRequest *request);
 	void send_connection_state_values_html(AsyncWebServerRequest *request);
 	void send_information_values_html(AsyncWebServerRequest *request);
@@ -208,6 +605,24 @@ protected:
 	void send_system_configuration_values_html(AsyncWebServerRequest *request);
 	void evaluate_system_post_html(AsyncWebServerRequest *request);
 
+	HTTPResponseParser _httpParser; // shared by checkFirmware and updateFirmware
+	enumFirmwareLastError httpParserError();
+	bool startFirmwareWrite(int statusCode);
+	bool writeFirmwareData(const uint8_t* data, size_t len);
+	bool flashFirmwareData(const uint8_t* data, size_t len);
+	strFlashStage _fwStage;
+	void initFirmwareStage();
+	void releaseFirmwareStage();
+	bool flushStageBuffer(uint8_t i);
+	void flushFirmwareStage();
+	void ackFirmwareStage(size_t current = 0);
+	void finishFirmwareUpdate();
+	void updateClientDisconnected();
+	void updateConnectFailed();
+	Ticker _fwResumeTk;
+	bool scheduleFirmwareResume();
+	static void s_resumeFirmware(void* arg);
+
 	void sendUpdateData();
 	void checkFirmware();
 	void updateFirmware(bool updSpiffs);
@@ -220,8 +635,8 @@ protected:
 	Ticker _LEDTk;
 	static void s_toggleLED();
 
-	static String decodeURIComponent(String input);
-	static String encodeURIComponent(String input);
+	static String decodeURIComponent(const String& input);
+	static String encodeURIComponent(const String& input);
 	static char int2hex(unsigned char c);
 	static unsigned char hex2int(char c);
 	static boolean checkRange(String Value);
@@ -0,0 +1,169 @@
+#include "GzipWriter.h"
+
+#define GZIP_MIN_MATCH 3
+#define GZIP_MAX_MATCH 258
+#define GZIP_NIL 0xFFFF
+
+static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// CRC-32 (IEEE), nibble table to keep flash usage small
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+	static const uint32_t table[16] = {
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+	};
+	crc = ~crc;
+	for (size_t i = 0; i < len; i++) {
+		crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+		crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+	}
+	return ~crc;
+}
+
+static inline uint16_t hash3(const uint8_t* p) {
+	return ((p[0] << 4) ^ (p[1] << 2) ^ p[2]) & ((1 << GZIP_HASH_BITS) - 1);
+}
+
+GzipWriter::GzipWriter(Print& out) : _out(out) {
+	_fill = 0;
+	_pos = 0;
+	for (size_t i = 0; i < (1 << GZIP_HASH_BITS); i++) _head[i] = GZIP_NIL;
+	_bitBuf = 0;
+	_bitCount = 0;
+	_outLen = 0;
+	_crc = 0;
+	_inSize = 0;
+	_outSize = 0;
+	_error = false;
+	//gzip header: magic, deflate, no flags, no mtime, no extra flags, OS unknown
+	static const uint8_t header[10] = { 0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF };
+	for (uint8_t i = 0; i < sizeof(header); i++) putByte(header[i]);
+	//one final block with fixed Huffman codes
+	putBits(1, 1);
+	putBits(1, 2);
+}
+
+size_t GzipWriter::write(const uint8_t* data, size_t len) {
+	if (_error) return 0;
+	_crc = crc32Update(_crc, data, len);
+	_inSize += len;
+	size_t done = 0;
+	while (done < len) {
+		if (_fill == sizeof(_buf)) {
+			//keep GZIP_MAX_MATCH bytes lookahead for the last matches
+			compress(_fill - GZIP_MAX_MATCH);
+			slide();
+		}
+		size_t n = sizeof(_buf) - _fill;
+		if (n > len - done) n = len - done;
+		memcpy(_buf + _fill, data + done, n);
+		_fill += n;
+		done += n;
+	}
+	return _error ? 0 : len;
+}
+
+bool GzipWriter::finish() {
+	compress(_fill);
+	putLiteral(256); //end of block
+	if (_bitCount) putByte(_bitBuf & 0xFF);
+	_bitBuf = 0;
+	_bitCount = 0;
+	for (uint8_t i = 0; i < 4; i++) putByte(_crc >> (8 * i));
+	for (uint8_t i = 0; i < 4; i++) putByte(_inSize >> (8 * i));
+	flushOut();
+	return !_error;
+}
+
+void GzipWriter::compress(size_t limit) {
+	while (_pos < limit) {
+		size_t avail = _fill - _pos;
+		if (avail >= GZIP_MIN_MATCH) {
+			uint16_t h = hash3(_buf + _pos);
+			uint16_t cand = _head[h];
+			_head[h] = _pos;
+			if ((cand != GZIP_NIL) && (cand < _pos) && (_pos - cand <= GZIP_WINDOW)) {
+				size_t maxLen = (avail < GZIP_MAX_MATCH) ? avail : GZIP_MAX_MATCH;
+				size_t len = 0;
+				while ((len < maxLen) && (_buf[cand + len] == _buf[_pos + len])) len++;
+				if (len >= GZIP_MIN_MATCH) {
+					putMatch(len, _pos - cand);
+					//remember the skipped positions as future candidates
+					for (size_t k = 1; (k < len) && (_pos + k + GZIP_MIN_MATCH <= _fill); k++) {
+						_head[hash3(_buf + _pos + k)] = _pos + k;
+					}
+					_pos += len;
+					continue;
+				}
+			}
+		}
+		putLiteral(_buf[_pos]);
+		_pos++;
+	}
+}
+
+// drops everything but the last GZIP_WINDOW bytes of history
+void GzipWriter::slide() {
+	if (_pos <= GZIP_WINDOW) return;
+	size_t shift = _pos - GZIP_WINDOW;
+	memmove(_buf, _buf + shift, _fill - shift);
+	_fill -= shift;
+	_pos -= shift;
+	for (size_t i = 0; i < (1 << GZIP_HASH_BITS); i++) {
+		_head[i] = ((_head[i] != GZIP_NIL) && (_head[i] >= shift)) ? _head[i] - shift : GZIP_NIL;
+	}
+}
+
+void GzipWriter::putBits(uint32_t value, uint8_t count) {
+	_bitBuf |= value << _bitCount;
+	_bitCount += count;
+	while (_bitCount >= 8) {
+		putByte(_bitBuf & 0xFF);
+		_bitBuf >>= 8;
+		_bitCount -= 8;
+	}
+}
+
+// Huffman codes are stored most significant bit first
+void GzipWriter::putCode(uint16_t code, uint8_t count) {
+	uint16_t reversed = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		reversed = (reversed << 1) | (code & 1);
+		code >>= 1;
+	}
+	putBits(reversed, count);
+}
+
+// fixed literal/length code (RFC 1951, 3.2.6)
+void GzipWriter::putLiteral(uint16_t lit) {
+	if (lit < 144) putCode(0x30 + lit, 8);
+	else if (lit < 256) putCode(0x190 + lit - 144, 9);
+	else if (lit < 280) putCode(lit - 256, 7);
+	else putCode(0xC0 + lit - 280, 8);
+}
+
+void GzipWriter::putMatch(size_t len, size_t dist) {
+	uint8_t i = 28;
+	while (lengthBase[i] > len) i--;
+	putLiteral(257 + i);
+	putBits(len - lengthBase[i], lengthExtra[i]);
+	uint8_t d = 29;
+	while (distBase[d] > dist) d--;
+	putCode(d, 5);
+	putBits(dist - distBase[d], distExtra[d]);
+}
+
+void GzipWriter::putByte(uint8_t b) {
+	_outBuf[_outLen++] = b;
+	if (_outLen == sizeof(_outBuf)) flushOut();
+}
+
+void GzipWriter::flushOut() {
+	if (!_outLen) return;
+	if (!_error && (_out.write(_outBuf, _outLen) != _outLen)) _error = true;
+	_outSize += _outLen;
+	_outLen = 0;
+}
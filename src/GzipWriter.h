@@ -0,0 +1,54 @@
+// GzipWriter.h
+
+#ifndef _GZIPWRITER_h
+#define _GZIPWRITER_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define GZIP_WINDOW 1024 // LZ77 history, the input buffer is twice this size
+#define GZIP_HASH_BITS 8
+#define GZIP_OUT_BUF 256 // compressed bytes collected before writing to the output
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len); // start with crc = 0
+
+// Streaming gzip compressor with a small window (about 3.3 KB of RAM).
+// Uses LZ77 with a single hash candidate and the fixed deflate Huffman
+// codes, which is plenty for html/css/js text and keeps the code small.
+class GzipWriter {
+public:
+	GzipWriter(Print& out);
+	size_t write(const uint8_t* data, size_t len); // returns 0 once the output failed
+	bool finish(); // flushes everything and writes the gzip trailer
+	uint32_t inputSize() const { return _inSize; }
+	uint32_t outputSize() const { return _outSize; }
+
+private:
+	Print& _out;
+	uint8_t _buf[2 * GZIP_WINDOW];
+	size_t _fill;
+	size_t _pos; // next byte to encode
+	uint16_t _head[1 << GZIP_HASH_BITS]; // last position of each hash
+	uint32_t _bitBuf;
+	uint8_t _bitCount;
+	uint8_t _outBuf[GZIP_OUT_BUF];
+	size_t _outLen;
+	uint32_t _crc;
+	uint32_t _inSize;
+	uint32_t _outSize;
+	bool _error;
+
+	void compress(size_t limit);
+	void slide();
+	void putBits(uint32_t value, uint8_t count);
+	void putCode(uint16_t code, uint8_t count);
+	void putLiteral(uint16_t lit);
+	void putMatch(size_t len, size_t dist);
+	void putByte(uint8_t b);
+	void flushOut();
+};
+
+#endif // _GZIPWRITER_h
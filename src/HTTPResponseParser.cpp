@@ -0,0 +1,201 @@
+#include "HTTPResponseParser.h"
+
+HTTPResponseParser::HTTPResponseParser() {
+	reset();
+}
+
+void HTTPResponseParser::reset() {
+	_state = HTTP_PARSE_STATUS;
+	_error = HTTP_PARSE_ERROR_NONE;
+	_statusCode = 0;
+	_contentLength = -1;
+	_chunked = false;
+	_chunkRemaining = 0;
+	_bodyReceived = 0;
+	_lineLen = 0;
+	_skipLine = false;
+}
+
+void HTTPResponseParser::onHeader(HTTP_HEADER_CALLBACK_SIGNATURE) {
+	this->headercallback = headercallback;
+}
+
+void HTTPResponseParser::onHeadersComplete(HTTP_HEADERS_DONE_CALLBACK_SIGNATURE) {
+	this->headersdonecallback = headersdonecallback;
+}
+
+void HTTPResponseParser::onBody(HTTP_BODY_CALLBACK_SIGNATURE) {
+	this->bodycallback = bodycallback;
+}
+
+bool HTTPResponseParser::fail(enumHTTPParseError error) {
+	_error = error;
+	_state = HTTP_PARSE_ERROR;
+	return false;
+}
+
+bool HTTPResponseParser::parse(const uint8_t* data, size_t len) {
+	size_t pos = 0;
+	while ((pos < len) && (_state != HTTP_PARSE_ERROR) && (_state != HTTP_PARSE_DONE)) {
+		//body bytes are passed through without copying
+		if (_state == HTTP_PARSE_BODY || _state == HTTP_PARSE_CHUNK_DATA) {
+			size_t n = len - pos;
+			if (_state == HTTP_PARSE_CHUNK_DATA) {
+				if (n > _chunkRemaining) n = _chunkRemaining;
+			}
+			else if ((_contentLength >= 0) && (n > (uint32_t)_contentLength - _bodyReceived)) {
+				n = (uint32_t)_contentLength - _bodyReceived;
+			}
+			_bodyReceived += n;
+			if (_state == HTTP_PARSE_CHUNK_DATA) {
+				_chunkRemaining -= n;
+				if (_chunkRemaining == 0) _state = HTTP_PARSE_CHUNK_END;
+			}
+			else if ((_contentLength >= 0) && (_bodyReceived >= (uint32_t)_contentLength)) {
+				_state = HTTP_PARSE_DONE;
+			}
+			if (bodycallback && !bodycallback(data + pos, n)) return fail(HTTP_PARSE_ERROR_ABORTED);
+			pos += n;
+			continue;
+		}
+		//line based states
+		const uint8_t* nl = (const uint8_t*)memchr(data + pos, '\n', len - pos);
+		size_t end = nl ? (size_t)(nl - data) : len;
+		if (_skipLine) {
+			//rest of an overlong header line
+			if (!nl) return true;
+			_skipLine = false;
+			pos = end + 1;
+			continue;
+		}
+		//same limit for whole and split lines, whether a line is split depends on the segmentation only
+		if (_lineLen + (end - pos) > HTTP_PARSER_LINE_MAX) {
+			//long cookies or policies are not needed => skip header lines, anything else is an error
+			if (_state != HTTP_PARSE_HEADERS && _state != HTTP_PARSE_TRAILER) return fail(HTTP_PARSE_ERROR_LINE_TOO_LONG);
+			_lineLen = 0;
+			if (!nl) {
+				_skipLine = true;
+				return true;
+			}
+			pos = end + 1;
+			continue;
+		}
+		const char* line;
+		size_t lineLen;
+		if (_lineLen || !nl) {
+			//line is split across segments => collect it
+			size_t n = end - pos;
+			memcpy(_line + _lineLen, data + pos, n);
+			_lineLen += n;
+			if (!nl) return true; // wait for the next segment
+			line = _line;
+			lineLen = _lineLen;
+		}
+		else {
+			line = (const char*)data + pos;
+			lineLen = end - pos;
+		}
+		pos = end + 1;
+		if (lineLen && line[lineLen - 1] == '\r') lineLen--;
+		bool okay = parseLine(line, lineLen);
+		_lineLen = 0;
+		if (!okay) return false;
+	}
+	return _state != HTTP_PARSE_ERROR;
+}
+
+bool HTTPResponseParser::parseLine(const char* line, size_t len) {
+	switch (_state)
+	{
+	case HTTP_PARSE_STATUS:
+		return parseStatusLine(line, len);
+	case HTTP_PARSE_HEADERS:
+		if (len) return parseHeaderLine(line, len);
+		//empty line => end of header
+		if (_chunked) _state = HTTP_PARSE_CHUNK_SIZE;
+		else if (_contentLength == 0) _state = HTTP_PARSE_DONE;
+		else _state = HTTP_PARSE_BODY;
+		if (headersdonecallback && !headersdonecallback(_statusCode)) return fail(HTTP_PARSE_ERROR_ABORTED);
+		return true;
+	case HTTP_PARSE_CHUNK_SIZE:
+		return parseChunkSize(line, len);
+	case HTTP_PARSE_CHUNK_END:
+		if (len) return fail(HTTP_PARSE_ERROR_CHUNK);
+		_state = HTTP_PARSE_CHUNK_SIZE;
+		return true;
+	case HTTP_PARSE_TRAILER:
+		if (!len) _state = HTTP_PARSE_DONE;
+		return true;
+	default:
+		return fail(HTTP_PARSE_ERROR_RESPONSE);
+	}
+}
+
+// "HTTP/x.y nnn reason"
+bool HTTPResponseParser::parseStatusLine(const char* line, size_t len) {
+	if ((len < 12) || (memcmp(line, "HTTP/", 5) != 0)) return fail(HTTP_PARSE_ERROR_RESPONSE);
+	const char* sp = (const char*)memchr(line, ' ', len);
+	if (!sp || (sp + 4 > line + len)) return fail(HTTP_PARSE_ERROR_RESPONSE);
+	for (uint8_t i = 1; i <= 3; i++) {
+		if (!isdigit(sp[i])) return fail(HTTP_PARSE_ERROR_RESPONSE);
+	}
+	_statusCode = (sp[1] - '0') * 100 + (sp[2] - '0') * 10 + (sp[3] - '0');
+	_state = HTTP_PARSE_HEADERS;
+	return true;
+}
+
+bool HTTPResponseParser::parseHeaderLine(const char* line, size_t len) {
+	const char* colon = (const char*)memchr(line, ':', len);
+	if (!colon) return fail(HTTP_PARSE_ERROR_HEADER);
+	size_t nameLen = colon - line;
+	const char* value = colon + 1;
+	size_t valueLen = len - nameLen - 1;
+	while (valueLen && (*value == ' ' || *value == '\t')) {
+		value++;
+		valueLen--;
+	}
+	if (headerIs(line, nameLen, "Content-Length")) {
+		_contentLength = toUInt(value, valueLen);
+	}
+	else if (headerIs(line, nameLen, "Transfer-Encoding")) {
+		_chunked = headerIs(value, valueLen, "chunked");
+	}
+	if (headercallback) headercallback(line, nameLen, value, valueLen);
+	return true;
+}
+
+bool HTTPResponseParser::parseChunkSize(const char* line, size_t len) {
+	uint32_t size = 0;
+	size_t i = 0;
+	for (; i < len; i++) {
+		char c = line[i];
+		if (c >= '0' && c <= '9') size = (size << 4) | (c - '0');
+		else if (c >= 'a' && c <= 'f') size = (size << 4) | (c - 'a' + 10);
+		else if (c >= 'A' && c <= 'F') size = (size << 4) | (c - 'A' + 10);
+		else break;
+	}
+	//at least one digit, optionally followed by extensions
+	if ((i == 0) || ((i < len) && (line[i] != ';') && (line[i] != ' '))) return fail(HTTP_PARSE_ERROR_CHUNK);
+	_chunkRemaining = size;
+	_state = size ? HTTP_PARSE_CHUNK_DATA : HTTP_PARSE_TRAILER;
+	return true;
+}
+
+// case insensitive compare of a not null terminated name
+bool HTTPResponseParser::headerIs(const char* name, size_t nameLen, const char* expected) {
+	return (strlen(expected) == nameLen) && (strncasecmp(name, expected, nameLen) == 0);
+}
+
+uint32_t HTTPResponseParser::toUInt(const char* value, size_t len) {
+	uint32_t result = 0;
+	for (size_t i = 0; (i < len) && isdigit(value[i]); i++) {
+		result = result * 10 + (value[i] - '0');
+	}
+	return result;
+}
+
+void HTTPResponseParser::assign(String& s, const char* value, size_t len) {
+	s = "";
+	s.reserve(len);
+	for (size_t i = 0; i < len; i++) s += value[i];
+}
@@ -0,0 +1,90 @@
+// HTTPResponseParser.h
+
+#ifndef _HTTPRESPONSEPARSER_h
+#define _HTTPRESPONSEPARSER_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#include <functional>
+
+#define HTTP_PARSER_LINE_MAX 128 // longest status/header/chunk size line (without \n), longer header lines are skipped, others are an error
+
+#define HTTP_HEADER_CALLBACK_SIGNATURE std::function<void(const char* name, size_t nameLen, const char* value, size_t valueLen)> headercallback
+#define HTTP_HEADERS_DONE_CALLBACK_SIGNATURE std::function<bool(int statusCode)> headersdonecallback
+#define HTTP_BODY_CALLBACK_SIGNATURE std::function<bool(const uint8_t* data, size_t len)> bodycallback
+
+typedef enum {
+	HTTP_PARSE_STATUS,
+	HTTP_PARSE_HEADERS,
+	HTTP_PARSE_BODY,
+	HTTP_PARSE_CHUNK_SIZE,
+	HTTP_PARSE_CHUNK_DATA,
+	HTTP_PARSE_CHUNK_END,
+	HTTP_PARSE_TRAILER,
+	HTTP_PARSE_DONE,
+	HTTP_PARSE_ERROR
+} enumHTTPParseState;
+
+typedef enum {
+	HTTP_PARSE_ERROR_NONE,
+	HTTP_PARSE_ERROR_RESPONSE, // no valid status line
+	HTTP_PARSE_ERROR_HEADER, // header line without ':'
+	HTTP_PARSE_ERROR_LINE_TOO_LONG,
+	HTTP_PARSE_ERROR_CHUNK, // invalid chunk size line
+	HTTP_PARSE_ERROR_ABORTED // a callback returned false
+} enumHTTPParseError;
+
+// Incremental parser for HTTP/1.x responses.
+// Feed every TCP segment to parse(); state survives between calls, so status
+// line, headers and chunk sizes may be split anywhere. Lines contained in one
+// segment are handed to the callbacks in place, only split lines are copied.
+class HTTPResponseParser {
+public:
+	HTTPResponseParser();
+	void reset();
+	bool parse(const uint8_t* data, size_t len); // false on error, see error()
+
+	void onHeader(HTTP_HEADER_CALLBACK_SIGNATURE);
+	void onHeadersComplete(HTTP_HEADERS_DONE_CALLBACK_SIGNATURE);
+	void onBody(HTTP_BODY_CALLBACK_SIGNATURE);
+
+	enumHTTPParseState state() const { return _state; }
+	enumHTTPParseError error() const { return _error; }
+	bool headersComplete() const { return _state > HTTP_PARSE_HEADERS; }
+	int statusCode() const { return _statusCode; }
+	int32_t contentLength() const { return _contentLength; } // -1 if unknown
+	bool chunked() const { return _chunked; }
+	uint32_t bodyReceived() const { return _bodyReceived; }
+
+	static bool headerIs(const char* name, size_t nameLen, const char* expected);
+	static uint32_t toUInt(const char* value, size_t len);
+	static void assign(String& s, const char* value, size_t len);
+
+private:
+	HTTP_HEADER_CALLBACK_SIGNATURE;
+	HTTP_HEADERS_DONE_CALLBACK_SIGNATURE;
+	HTTP_BODY_CALLBACK_SIGNATURE;
+
+	enumHTTPParseState _state;
+	enumHTTPParseError _error;
+	int _statusCode;
+	int32_t _contentLength;
+	bool _chunked;
+	uint32_t _chunkRemaining;
+	uint32_t _bodyReceived;
+	char _line[HTTP_PARSER_LINE_MAX];
+	size_t _lineLen;
+	bool _skipLine; // discarding an overlong header line up to its \n
+
+	bool parseLine(const char* line, size_t len);
+	bool parseStatusLine(const char* line, size_t len);
+	bool parseHeaderLine(const char* line, size_t len);
+	bool parseChunkSize(const char* line, size_t len);
+	bool fail(enumHTTPParseError error);
+};
+
+#endif // _HTTPRESPONSEPARSER_h
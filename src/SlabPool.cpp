@@ -0,0 +1,119 @@
+#include "SlabPool.h"
+
+static SlabPool pools[SLAB_POOLS] = {
+	SlabPool(SLAB_SMALL_SIZE, SLAB_SMALL_COUNT),
+	SlabPool(SLAB_MEDIUM_SIZE, SLAB_MEDIUM_COUNT),
+	SlabPool(SLAB_LARGE_SIZE, SLAB_LARGE_COUNT)
+};
+
+SlabPool::SlabPool(uint16_t blockSize, uint8_t blocks) {
+	_arena = NULL;
+	_freeMask = 0;
+	memset(&_stats, 0, sizeof(_stats));
+	_stats.blockSize = blockSize;
+	_stats.blocks = (blocks > 32) ? 32 : blocks;
+}
+
+bool SlabPool::begin() {
+	if (_arena) return true;
+	_arena = (uint8_t*)malloc((size_t)_stats.blockSize * _stats.blocks);
+	if (!_arena) return false;
+	_freeMask = (_stats.blocks == 32) ? 0xFFFFFFFF : ((1UL << _stats.blocks) - 1);
+	return true;
+}
+
+void* SlabPool::alloc() {
+	if (!_freeMask) return NULL;
+	uint8_t i = __builtin_ctz(_freeMask);
+	_freeMask &= ~(1UL << i);
+	_stats.allocs++;
+	if (++_stats.used > _stats.peak) _stats.peak = _stats.used;
+	return _arena + (size_t)i * _stats.blockSize;
+}
+
+void SlabPool::release(void* p) {
+	uint8_t i = ((uint8_t*)p - _arena) / _stats.blockSize;
+	_freeMask |= (1UL << i);
+	_stats.used--;
+}
+
+bool SlabPool::owns(const void* p) const {
+	return _arena && ((const uint8_t*)p >= _arena) && ((const uint8_t*)p < _arena + (size_t)_stats.blockSize * _stats.blocks);
+}
+
+// call early, before the heap gets busy, so the arenas sit next to each other
+bool slabBegin() {
+	bool okay = true;
+	for (uint8_t i = 0; i < SLAB_POOLS; i++) okay &= pools[i].begin();
+	return okay;
+}
+
+void* slabAlloc(size_t size, size_t* capacity) {
+	int8_t fitting = -1;
+	for (uint8_t i = 0; i < SLAB_POOLS; i++) {
+		if (pools[i].stats().blockSize < size) continue;
+		if (fitting < 0) fitting = i;
+		void* p = pools[i].alloc();
+		if (p) {
+			if (capacity) *capacity = pools[i].stats().blockSize;
+			return p;
+		}
+	}
+	if (fitting >= 0) pools[fitting].countFallback();
+	if (capacity) *capacity = size;
+	return malloc(size);
+}
+
+void slabFree(void* p) {
+	if (!p) return;
+	for (uint8_t i = 0; i < SLAB_POOLS; i++) {
+		if (pools[i].owns(p)) return pools[i].release(p);
+	}
+	free(p);
+}
+
+const strSlabStats& slabStats(uint8_t pool) {
+	return pools[pool].stats();
+}
+
+PooledBuffer::PooledBuffer(size_t sizeHint) {
+	_buf = NULL;
+	_capacity = 0;
+	_length = 0;
+	if (sizeHint) reserve(sizeHint);
+}
+
+PooledBuffer::~PooledBuffer() {
+	slabFree(_buf);
+}
+
+size_t PooledBuffer::write(uint8_t c) {
+	return write(&c, 1);
+}
+
+size_t PooledBuffer::write(const uint8_t* data, size_t len) {
+	if (!reserve(_length + len)) return 0;
+	memcpy(_buf + _length, data, len);
+	_length += len;
+	return len;
+}
+
+const char* PooledBuffer::c_str() {
+	if (!reserve(_length + 1)) return "";
+	_buf[_length] = '\0';
+	return (const char*)_buf;
+}
+
+// grows into the next size class (or the heap beyond the largest one)
+bool PooledBuffer::reserve(size_t size) {
+	if (size <= _capacity) return true;
+	size_t wanted = (size < 2 * _capacity) ? 2 * _capacity : size;
+	size_t capacity;
+	uint8_t* buf = (uint8_t*)slabAlloc(wanted, &capacity);
+	if (!buf) return false;
+	if (_length) memcpy(buf, _buf, _length);
+	slabFree(_buf);
+	_buf = buf;
+	_capacity = capacity;
+	return true;
+}
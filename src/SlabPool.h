@@ -0,0 +1,70 @@
+// SlabPool.h
+
+#ifndef _SLABPOOL_h
+#define _SLABPOOL_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+// Size classes, each one arena allocated once by slabBegin() (at most 32 blocks per class)
+#define SLAB_SMALL_SIZE 256
+#define SLAB_SMALL_COUNT 4
+#define SLAB_MEDIUM_SIZE 1024
+#define SLAB_MEDIUM_COUNT 3
+#define SLAB_LARGE_SIZE 2048
+#define SLAB_LARGE_COUNT 1
+#define SLAB_POOLS 3
+
+typedef struct {
+	uint16_t blockSize;
+	uint8_t blocks;
+	uint8_t used;
+	uint8_t peak;
+	uint32_t allocs;
+	uint32_t fallbacks; // requests of this class served by malloc because all fitting blocks were taken
+} strSlabStats;
+
+// Fixed size blocks from one arena, a bit per block marks it as free
+class SlabPool {
+public:
+	SlabPool(uint16_t blockSize, uint8_t blocks);
+	bool begin();
+	void* alloc(); // NULL if empty
+	void release(void* p);
+	bool owns(const void* p) const;
+	const strSlabStats& stats() const { return _stats; }
+	void countFallback() { _stats.fallbacks++; }
+
+private:
+	uint8_t* _arena;
+	uint32_t _freeMask;
+	strSlabStats _stats;
+};
+
+bool slabBegin();
+void* slabAlloc(size_t size, size_t* capacity = NULL); // smallest fitting free block, malloc() if none
+void slabFree(void* p); // blocks from slabAlloc() only
+const strSlabStats& slabStats(uint8_t pool);
+
+// Growable Print target backed by slab blocks, for response and event builders
+class PooledBuffer : public Print {
+public:
+	PooledBuffer(size_t sizeHint = 0);
+	~PooledBuffer();
+	virtual size_t write(uint8_t c) override;
+	virtual size_t write(const uint8_t* data, size_t len) override;
+	const uint8_t* data() const { return _buf; }
+	size_t length() const { return _length; }
+	const char* c_str(); // NUL terminated, not part of length()
+
+private:
+	uint8_t* _buf;
+	size_t _capacity;
+	size_t _length;
+	bool reserve(size_t size);
+};
+
+#endif // _SLABPOOL_h
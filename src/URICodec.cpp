@@ -0,0 +1,67 @@
+#include "URICodec.h"
+
+// per character: URI_UNRESERVED, URI_HEX | value of the hex digit
+// accepted Characters: A-Z a-z 0-9 - _ . ! ~ * ' ( )
+static const uint8_t uriClass[256] = {
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00, 0x80, 0x80, 0x00,
+	0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00, 0x00, 0x00, 0x80,
+	0x00, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+	0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00, 0x00, 0x00, 0x80, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+// Decodes %XX and '+'. Works in place (out == in), out needs len bytes.
+// A '%' not followed by two hex digits is kept as it is.
+size_t uriDecode(const char* in, size_t len, char* out) {
+	size_t o = 0;
+	for (size_t i = 0; i < len; i++) {
+		char c = in[i];
+		if (c == '+') c = ' ';
+		else if ((c == '%') && (len - i > 2)) {
+			uint8_t hi = uriClass[(uint8_t)in[i + 1]];
+			uint8_t lo = uriClass[(uint8_t)in[i + 2]];
+			if ((hi & URI_HEX) && (lo & URI_HEX)) {
+				c = ((hi & 0x0F) << 4) | (lo & 0x0F);
+				i += 2;
+			}
+		}
+		out[o++] = c;
+	}
+	return o;
+}
+
+size_t uriEncodedLength(const char* in, size_t len) {
+	size_t n = len;
+	for (size_t i = 0; i < len; i++) {
+		if (!(uriClass[(uint8_t)in[i]] & URI_UNRESERVED)) n += 2;
+	}
+	return n;
+}
+
+// out needs uriEncodedLength() bytes
+size_t uriEncode(const char* in, size_t len, char* out) {
+	static const char hex[] = "0123456789ABCDEF";
+	size_t o = 0;
+	for (size_t i = 0; i < len; i++) {
+		uint8_t c = in[i];
+		if (uriClass[c] & URI_UNRESERVED) {
+			out[o++] = c;
+			continue;
+		}
+		out[o++] = '%';
+		out[o++] = hex[c >> 4];
+		out[o++] = hex[c & 0x0F];
+	}
+	return o;
+}
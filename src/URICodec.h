@@ -0,0 +1,20 @@
+// URICodec.h
+
+#ifndef _URICODEC_h
+#define _URICODEC_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#define URI_UNRESERVED 0x80 // uriClass flags
+#define URI_HEX 0x40
+
+// Table driven URI component codec on plain buffers, no heap use
+size_t uriDecode(const char* in, size_t len, char* out);
+size_t uriEncode(const char* in, size_t len, char* out);
+size_t uriEncodedLength(const char* in, size_t len);
+
+#endif // _URICODEC_h
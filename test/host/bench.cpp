@@ -0,0 +1,255 @@
+// Host benchmark: the String based code this library used before against the
+// buffer based replacements. Prints ns/op and heap allocations per op; on the
+// ESP8266 the allocation count matters more than the time. The server parts
+// run on the host stand-ins, so they measure the library code, not the link.
+
+#include "URICodec.h"
+#include "SlabPool.h"
+#include "GzipWriter.h"
+#include "HTTPResponseParser.h"
+#include "host_server.h"
+#include <chrono>
+#include <string>
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+extern "C" void* __libc_calloc(size_t n, size_t size);
+extern "C" void __libc_free(void* p);
+
+static unsigned long allocCount = 0;
+
+extern "C" void* malloc(size_t size) { allocCount++; return __libc_malloc(size); }
+extern "C" void* realloc(void* p, size_t size) { allocCount++; return __libc_realloc(p, size); }
+extern "C" void* calloc(size_t n, size_t size) { allocCount++; return __libc_calloc(n, size); }
+extern "C" void free(void* p) { __libc_free(p); }
+
+// runs fn iterations times and prints one line
+template<typename F> static void bench(const char* name, unsigned long iterations, F fn) {
+	fn(); // warm up
+	unsigned long allocs = allocCount;
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned long i = 0; i < iterations; i++) fn();
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	printf("%-34s %10.1f ns/op %8.1f allocs/op\n", name, (double)ns / iterations, (double)(allocCount - allocs) / iterations);
+}
+
+static volatile size_t sink;
+
+// before: baseline AsyncFSWebServer::decodeURIComponent/encodeURIComponent
+static uint8_t hex2int(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return 0;
+}
+
+static char int2hex(uint8_t c) {
+	if (c <= 9) return '0' + c;
+	if (c >= 10 && c <= 15) return 'A' + c - 10;
+	return '0';
+}
+
+static String oldDecode(String input) {
+	char c;
+	String ret = "";
+	for (byte t = 0; t < input.length(); t++) {
+		c = input[t];
+		if (c == '+') c = ' ';
+		if (c == '%') {
+			t++;
+			c = input[t];
+			t++;
+			c = (hex2int(c) << 4) | hex2int(input[t]);
+		}
+		ret.concat(c);
+	}
+	return ret;
+}
+
+static String oldEncode(String input) {
+	char c;
+	String ret = "";
+	for (byte t = 0; t < input.length(); t++) {
+		c = input[t];
+		if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.' || c == '!' || c == '~' || c == '*' || c == 0x27 || c == '(' || c == ')') {
+			ret.concat(c);
+			continue;
+		}
+		ret.concat('%');
+		ret.concat(int2hex((unsigned char)c >> 4));
+		ret.concat(int2hex((unsigned char)c & 0x0F));
+	}
+	return ret;
+}
+
+// after: AsyncFSWebServer::decodeURIComponent/encodeURIComponent on the kernels
+static String newDecode(const String& input) {
+	String ret = input;
+	char* buf = const_cast<char*>(ret.c_str());
+	ret.remove(uriDecode(buf, ret.length(), buf));
+	return ret;
+}
+
+static String newEncode(const String& input) {
+	String ret;
+	if (!ret.reserve(uriEncodedLength(input.c_str(), input.length()))) return ret;
+	char block[3 * 16 + 1];
+	const char* in = input.c_str();
+	size_t left = input.length();
+	while (left) {
+		size_t n = (left < 16) ? left : 16;
+		size_t o = uriEncode(in, n, block);
+		block[o] = 0;
+		ret.concat(block);
+		in += n;
+		left -= n;
+	}
+	return ret;
+}
+
+// the network page of the Micro-AJAX interface, built both ways
+static const char* ssid = "My Home Network 2.4GHz";
+static const char* password = "s3cr3t/pass&word!";
+
+static void oldAjax() {
+	String values = "";
+	values += "ssid|" + oldEncode(String(ssid)) + "|input\n";
+	values += "password|" + oldEncode(String(password)) + "|input\n";
+	values += "ip|" + String("192.168.1.50") + "|input\n";
+	values += "nm|" + String("255.255.255.0") + "|input\n";
+	values += "gw|" + String("192.168.1.1") + "|input\n";
+	values += "dns|" + String("192.168.1.1") + "|input\n";
+	values += "dhcp|" + String("checked") + "|chk\n";
+	sink = values.length();
+}
+
+static void printEncoded(Print& out, const char* key, const char* value, const char* type) {
+	out.print(key);
+	out.print('|');
+	char block[3 * 16];
+	for (size_t left = strlen(value); left;) {
+		size_t n = (left < 16) ? left : 16;
+		out.write((const uint8_t*)block, uriEncode(value, n, block));
+		value += n;
+		left -= n;
+	}
+	out.print('|');
+	out.print(type);
+	out.print('\n');
+}
+
+static void printValue(Print& out, const char* key, const char* value, const char* type) {
+	out.print(key);
+	out.print('|');
+	out.print(value);
+	out.print('|');
+	out.print(type);
+	out.print('\n');
+}
+
+static void newAjax() {
+	PooledBuffer out(256);
+	printEncoded(out, "ssid", ssid, "input");
+	printEncoded(out, "password", password, "input");
+	printValue(out, "ip", "192.168.1.50", "input");
+	printValue(out, "nm", "255.255.255.0", "input");
+	printValue(out, "gw", "192.168.1.1", "input");
+	printValue(out, "dns", "192.168.1.1", "input");
+	printValue(out, "dhcp", "checked", "chk");
+	sink = out.length();
+}
+
+class NullPrint : public Print {
+public:
+	virtual size_t write(uint8_t c) override { return 1; }
+	virtual size_t write(const uint8_t* data, size_t len) override { return len; }
+};
+
+int main() {
+	slabBegin();
+	String encoded("My%20Home%20Network%202.4GHz+s3cr3t%2Fpass%26word%21");
+	String plain("My Home Network 2.4GHz s3cr3t/pass&word!");
+
+	printf("URI codec (%u / %u byte argument)\n", encoded.length(), plain.length());
+	bench("  decodeURIComponent before", 200000, [&]() { sink = oldDecode(encoded).length(); });
+	bench("  decodeURIComponent after", 200000, [&]() { sink = newDecode(encoded).length(); });
+	bench("  encodeURIComponent before", 200000, [&]() { sink = oldEncode(plain).length(); });
+	bench("  encodeURIComponent after", 200000, [&]() { sink = newEncode(plain).length(); });
+
+	printf("Micro-AJAX network values\n");
+	bench("  String concatenation (before)", 200000, oldAjax);
+	bench("  PooledBuffer (after)", 200000, newAjax);
+
+	std::string page;
+	while (page.size() < 8192) page += "<div class=\"row\"><label>Field</label><input type=\"text\" value=\"\"></div>\n";
+	page.resize(8192);
+
+	std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nx-MD5: 0123456789abcdef\r\nTransfer-Encoding: chunked\r\n\r\n";
+	for (int i = 0; i < 8; i++) response += "400\r\n" + page.substr(i * 1024, 1024) + "\r\n";
+	response += "0\r\n\r\n";
+	printf("Streaming (8 KB)\n");
+	HTTPResponseParser parser;
+	parser.onBody([](const uint8_t* data, size_t len) { sink = len; return true; });
+	bench("  HTTPResponseParser, 536 B segments", 20000, [&]() {
+		parser.reset();
+		for (size_t pos = 0; pos < response.size(); pos += 536) {
+			parser.parse((const uint8_t*)response.data() + pos, std::min((size_t)536, response.size() - pos));
+		}
+	});
+	NullPrint null;
+	bench("  GzipWriter, html", 2000, [&]() {
+		GzipWriter gz(null);
+		gz.write((const uint8_t*)page.data(), page.size());
+		gz.finish();
+		sink = gz.outputSize();
+	});
+
+	HostServer server;
+	fs::FS flash;
+	std::string admin = page.substr(0, 6000);
+	flash.hostWrite("/admin.html", admin, 1500000000);
+	flash.hostWrite("/style.css.gz", std::string(1400, 'c'), 1500000000);
+	flash.hostWrite("/microajax.js.gz", std::string(900, 'j'), 1500000000);
+	server.begin(&flash);
+	server._firmware.server = "fw.local";
+
+	//user-008: the image streams through the staging buffers, flash writes happen in handle()
+	std::string image(1024 * 1024, 0);
+	for (size_t i = 0; i < image.size(); i++) image[i] = (char)(i * 31 + (i >> 8));
+	printf("OTA download (1 MB, 1460 B segments)\n");
+	for (size_t perLoop = 1; perLoop <= 8; perLoop *= 8) {
+		auto start = std::chrono::steady_clock::now();
+		server.updateFirmware(false);
+		bool ok = hostServeFirmware(server, image, perLoop);
+		double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("  %u segment(s) per handle()          %10.1f MB/s %5u sector writes%s\n", (unsigned)perLoop, image.size() / s / 1e6, Update.hostWrites, (ok && Update.hostFinished) ? "" : " (failed)");
+	}
+
+	//user-025: admin.html and its assets, one connection each (the server closes after the response)
+	static const char* const assets[] = { "/admin.html", "/style.css", "/microajax.js" };
+	String etags[3];
+	size_t pageBytes = 0;
+	for (uint8_t i = 0; i < 3; i++) {
+		HostRequest r(server, HTTP_GET, assets[i]);
+		r.run();
+		etags[i] = r.responseHeader("ETag");
+		pageBytes += r.body().size();
+	}
+	printf("admin.html page load (%u requests, %u body bytes)\n", 3, (unsigned)pageBytes);
+	bench("  first load, 200 with body", 2000, [&]() {
+		for (uint8_t i = 0; i < 3; i++) {
+			HostRequest r(server, HTTP_GET, assets[i]);
+			r.run();
+			sink = r.body().size();
+		}
+	});
+	bench("  reload, 304 revalidation", 2000, [&]() {
+		for (uint8_t i = 0; i < 3; i++) {
+			HostRequest r(server, HTTP_GET, assets[i]);
+			r.header("If-None-Match", etags[i]);
+			r.run();
+			sink = r.status();
+		}
+	});
+	return 0;
+}
@@ -0,0 +1,93 @@
+// host_server.h - runs requests through AsyncFSWebServer on the host stand-ins
+
+#ifndef _HOST_SERVER_h
+#define _HOST_SERVER_h
+
+#include "FSWebServerLib.h"
+#include <string>
+#include <algorithm>
+
+// the internals the tests look at
+class HostServer : public AsyncFSWebServer {
+public:
+	HostServer() : AsyncFSWebServer(80) {}
+	using AsyncFSWebServer::handleFileRead;
+	using AsyncFSWebServer::_admitted;
+	using AsyncFSWebServer::_requestsRejected;
+	using AsyncFSWebServer::_uploads;
+	using AsyncFSWebServer::_httpAuth;
+	using AsyncFSWebServer::_firmware;
+	using AsyncFSWebServer::_fwStage;
+	using AsyncFSWebServer::_asyncClient;
+	using AsyncFSWebServer::_metricsNotFound;
+	using AsyncFSWebServer::findRoute;
+	using AsyncFSWebServer::updateFirmware;
+};
+
+// One connection with one request, like ESPAsyncWebServer creates them.
+// The destructor is the server closing the connection after the response.
+class HostRequest {
+public:
+	HostRequest(AsyncWebServer& server, WebRequestMethodComposite method, const char* url) : _server(server) {
+		static uint16_t nextPort = 49152;
+		client = new AsyncClient();
+		client->hostAccept(0x3201a8c0, nextPort++, 80); // 192.168.1.50
+		request = new AsyncWebServerRequest(&server, client, method, url);
+	}
+	~HostRequest() {
+		delete request;
+		delete client;
+	}
+	HostRequest& header(const char* name, const String& value) { request->hostHeader(name, value); return *this; }
+	HostRequest& param(const char* name, const String& value) { request->hostParam(name, value); return *this; }
+	void attach() { _server.hostAttach(request); }
+	AsyncWebServerResponse* handle() { _server.hostHandle(request); return request->hostResponse(); }
+	AsyncWebServerResponse* run() { attach(); return handle(); }
+	int status() const { return request->hostResponse() ? request->hostResponse()->hostCode() : 0; }
+	std::string body() const { return request->hostResponse() ? request->hostResponse()->hostBody() : std::string(); }
+	String responseHeader(const char* name) const {
+		const AsyncWebHeader* h = request->hostResponse() ? request->hostResponse()->hostHeader(name) : NULL;
+		return h ? h->value() : String();
+	}
+
+	AsyncClient* client;
+	AsyncWebServerRequest* request;
+
+private:
+	AsyncWebServer& _server;
+};
+
+// Answers the request of updateFirmware() with the image. The sender keeps at
+// most FW_STAGE_TCP_WND bytes unacked like TCP would, handle() runs after
+// every segmentsPerLoop segments like loop() would. False if the transfer stalls.
+static inline bool hostServeFirmware(HostServer& server, const std::string& image, size_t segmentsPerLoop = 1, size_t segment = 1460) {
+	AsyncClient* c = server._asyncClient;
+	if (!c || !c->hostConnecting) return false;
+	c->hostConnected();
+	char header[160];
+	snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Length: %u\r\nx-esp8266-updateSize: %u\r\nx-esp8266-MD5: 0123456789abcdef0123456789abcdef\r\n\r\n", (unsigned)image.size(), (unsigned)image.size());
+	c->hostReceive(header, strlen(header));
+	size_t sent = 0;
+	size_t segments = 0;
+	uint32_t stalls = 0;
+	while (sent < image.size()) {
+		size_t n = std::min(segment, image.size() - sent);
+		if (c->hostReceived + n - c->hostAcked > FW_STAGE_TCP_WND) {
+			//window closed => only handle() can open it again
+			server.handle();
+			if (++stalls > 100) return false;
+			continue;
+		}
+		stalls = 0;
+		c->hostReceive(image.data() + sent, n);
+		sent += n;
+		if (++segments % segmentsPerLoop == 0) server.handle();
+	}
+	for (int i = 0; (i < 4) && c->connected(); i++) {
+		server.handle();
+		c->hostPoll();
+	}
+	return !c->connected();
+}
+
+#endif // _HOST_SERVER_h
@@ -0,0 +1,271 @@
+#include "Arduino.h"
+#include <chrono>
+
+static uint32_t hostMillis = 0;
+
+uint32_t millis() {
+	return hostMillis;
+}
+
+void hostSetMillis(uint32_t ms) {
+	hostMillis = ms;
+}
+
+uint32_t micros() {
+	using namespace std::chrono;
+	return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void delay(unsigned long ms) {
+	hostMillis += ms;
+}
+
+void yield() {}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+	if (value) GPO |= (1 << pin);
+	else GPO &= ~(1 << pin);
+}
+
+int digitalRead(uint8_t pin) {
+	return (GPI >> pin) & 1;
+}
+
+int analogRead(uint8_t pin) {
+	return 512;
+}
+
+uint32_t GPI = 0, GPO = 0, GP16I = 0;
+
+// xorshift, fixed seed => runs are repeatable
+uint32_t hostRandom() {
+	static uint32_t state = 2463534242u;
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(uint8_t c) {
+	return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t len) {
+	return fwrite(data, 1, len, stdout);
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getFreeHeap() {
+	return 40000;
+}
+
+uint32_t EspClass::getMaxFreeBlockSize() {
+	return 30000;
+}
+
+void EspClass::restart() {
+	hostRestarts++;
+}
+
+size_t hostStrlcpy(char* dst, const char* src, size_t size) {
+	size_t len = strlen(src);
+	if (size) {
+		size_t n = (len < size - 1) ? len : size - 1;
+		memcpy(dst, src, n);
+		dst[n] = '\0';
+	}
+	return len;
+}
+
+String::String(const char* s) : _buf(NULL), _capacity(0), _len(0) {
+	concat(s ? s : "");
+}
+
+String::String(const String& s) : _buf(NULL), _capacity(0), _len(0) {
+	concat(s);
+}
+
+String::String(char c) : _buf(NULL), _capacity(0), _len(0) {
+	concat(c);
+}
+
+String::String(unsigned int value) : _buf(NULL), _capacity(0), _len(0) {
+	char buf[12];
+	concat(buf, snprintf(buf, sizeof(buf), "%u", value));
+}
+
+String::String(int value) : _buf(NULL), _capacity(0), _len(0) {
+	char buf[12];
+	concat(buf, snprintf(buf, sizeof(buf), "%d", value));
+}
+
+String::String(unsigned long value) : _buf(NULL), _capacity(0), _len(0) {
+	char buf[24];
+	concat(buf, snprintf(buf, sizeof(buf), "%lu", value));
+}
+
+String::String(long value) : _buf(NULL), _capacity(0), _len(0) {
+	char buf[24];
+	concat(buf, snprintf(buf, sizeof(buf), "%ld", value));
+}
+
+String::String(double value, unsigned char decimals) : _buf(NULL), _capacity(0), _len(0) {
+	char buf[40];
+	concat(buf, snprintf(buf, sizeof(buf), "%.*f", decimals, value));
+}
+
+String::~String() {
+	free(_buf);
+}
+
+String& String::operator=(const String& s) {
+	if (this != &s) {
+		_len = 0;
+		concat(s);
+	}
+	return *this;
+}
+
+String& String::operator=(const char* s) {
+	_len = 0;
+	concat(s);
+	return *this;
+}
+
+bool String::reserve(unsigned int size) {
+	if (_buf && (_capacity >= size)) return true;
+	char* buf = (char*)realloc(_buf, size + 1);
+	if (!buf) return false;
+	if (!_buf) buf[0] = '\0';
+	_buf = buf;
+	_capacity = size;
+	return true;
+}
+
+bool String::concat(const char* s, unsigned int len) {
+	if (!reserve(_len + len)) return false;
+	memmove(_buf + _len, s, len);
+	_len += len;
+	_buf[_len] = '\0';
+	return true;
+}
+
+String operator+(const String& a, const String& b) {
+	String r(a);
+	r.concat(b);
+	return r;
+}
+
+String operator+(const String& a, const char* b) {
+	String r(a);
+	r.concat(b);
+	return r;
+}
+
+String operator+(const char* a, const String& b) {
+	String r(a);
+	r.concat(b);
+	return r;
+}
+
+bool String::startsWith(const char* prefix) const {
+	size_t n = strlen(prefix);
+	return (n <= _len) && (strncmp(c_str(), prefix, n) == 0);
+}
+
+bool String::endsWith(const char* suffix) const {
+	size_t n = strlen(suffix);
+	return (n <= _len) && (strcmp(c_str() + _len - n, suffix) == 0);
+}
+
+int String::indexOf(const char* s, unsigned int from) const {
+	if (from > _len) return -1;
+	const char* found = strstr(c_str() + from, s);
+	return found ? (int)(found - c_str()) : -1;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+	if (from > _len) return -1;
+	const char* found = strchr(c_str() + from, c);
+	return (found && (found < c_str() + _len)) ? (int)(found - c_str()) : -1;
+}
+
+int String::lastIndexOf(char c) const {
+	const char* found = strrchr(c_str(), c);
+	return found ? (int)(found - c_str()) : -1;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+	String r;
+	if (to > _len) to = _len;
+	if (from < to) r.concat(c_str() + from, to - from);
+	return r;
+}
+
+void String::toLowerCase() {
+	for (unsigned int i = 0; i < _len; i++) _buf[i] = tolower(_buf[i]);
+}
+
+void String::trim() {
+	unsigned int start = 0;
+	while ((start < _len) && isspace(_buf[start])) start++;
+	unsigned int end = _len;
+	while ((end > start) && isspace(_buf[end - 1])) end--;
+	remove(end);
+	remove(0, start);
+}
+
+void String::remove(unsigned int index) {
+	if (index < _len) {
+		_len = index;
+		_buf[_len] = '\0';
+	}
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+	if (index >= _len) return;
+	if (count > _len - index) count = _len - index;
+	memmove(_buf + index, _buf + index + count, _len - index - count + 1);
+	_len -= count;
+}
+
+size_t Print::write(const uint8_t* data, size_t len) {
+	size_t n = 0;
+	while (len--) n += write(*data++);
+	return n;
+}
+
+size_t Print::print(unsigned int value) {
+	char buf[12];
+	return write((const uint8_t*)buf, snprintf(buf, sizeof(buf), "%u", value));
+}
+
+size_t Print::print(int value) {
+	char buf[12];
+	return write((const uint8_t*)buf, snprintf(buf, sizeof(buf), "%d", value));
+}
+
+// like the ESP8266 core: stack buffer first, heap only for long output
+size_t Print::printf(const char* format, ...) {
+	va_list arg;
+	va_start(arg, format);
+	char temp[64];
+	char* buffer = temp;
+	size_t len = vsnprintf(temp, sizeof(temp), format, arg);
+	va_end(arg);
+	if (len > sizeof(temp) - 1) {
+		buffer = (char*)malloc(len + 1);
+		if (!buffer) return 0;
+		va_start(arg, format);
+		vsnprintf(buffer, len + 1, format, arg);
+		va_end(arg);
+	}
+	len = write((const uint8_t*)buffer, len);
+	if (buffer != temp) free(buffer);
+	return len;
+}
@@ -0,0 +1,161 @@
+// Arduino.h - minimal stand-in for building the library on a Linux host
+
+#ifndef _HOST_ARDUINO_h
+#define _HOST_ARDUINO_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <math.h>
+#include <functional>
+#include <memory>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define LOW 0x0
+#define HIGH 0x1
+#define A0 17
+
+uint32_t millis();
+void hostSetMillis(uint32_t ms); // tests drive the clock
+uint32_t micros(); // real time, for the benchmarks
+void delay(unsigned long ms); // advances millis()
+void yield();
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+// hardware registers
+extern uint32_t GPI, GPO, GP16I;
+uint32_t hostRandom();
+#define RANDOM_REG32 hostRandom()
+
+// glibc < 2.38 has no strlcpy, newer ones declare it differently
+size_t hostStrlcpy(char* dst, const char* src, size_t size);
+#define strlcpy hostStrlcpy
+
+// Same growth policy as the ESP8266 core: reserve() allocates exactly what is asked for
+class String {
+public:
+	String(const char* s = "");
+	String(const String& s);
+	explicit String(char c);
+	explicit String(unsigned int value);
+	explicit String(int value);
+	explicit String(unsigned long value);
+	explicit String(long value);
+	explicit String(double value, unsigned char decimals = 2);
+	~String();
+	String& operator=(const String& s);
+	String& operator=(const char* s);
+
+	bool reserve(unsigned int size);
+	unsigned int length() const { return _len; }
+	const char* c_str() const { return _buf ? _buf : ""; }
+	char operator[](unsigned int index) const { return (index < _len) ? _buf[index] : 0; }
+
+	bool concat(const char* s, unsigned int len);
+	bool concat(const char* s) { return concat(s, strlen(s)); }
+	bool concat(const String& s) { return concat(s.c_str(), s._len); }
+	bool concat(char c) { return concat(&c, 1); }
+	String& operator+=(const char* s) { concat(s); return *this; }
+	String& operator+=(const String& s) { concat(s); return *this; }
+	String& operator+=(char c) { concat(c); return *this; }
+	friend String operator+(const String& a, const String& b);
+	friend String operator+(const String& a, const char* b);
+	friend String operator+(const char* a, const String& b);
+
+	bool operator==(const char* s) const { return strcmp(c_str(), s) == 0; }
+	bool operator==(const String& s) const { return (_len == s._len) && (strcmp(c_str(), s.c_str()) == 0); }
+	bool operator!=(const char* s) const { return !(*this == s); }
+	bool operator!=(const String& s) const { return !(*this == s); }
+	bool equals(const char* s) const { return *this == s; }
+	bool startsWith(const char* prefix) const;
+	bool startsWith(const String& prefix) const { return startsWith(prefix.c_str()); }
+	bool endsWith(const char* suffix) const;
+	bool endsWith(const String& suffix) const { return endsWith(suffix.c_str()); }
+	int indexOf(const char* s, unsigned int from = 0) const;
+	int indexOf(const String& s, unsigned int from = 0) const { return indexOf(s.c_str(), from); }
+	int indexOf(char c, unsigned int from = 0) const;
+	int lastIndexOf(char c) const;
+	String substring(unsigned int from) const { return substring(from, _len); }
+	String substring(unsigned int from, unsigned int to) const;
+	long toInt() const { return atol(c_str()); }
+	float toFloat() const { return atof(c_str()); }
+	void toLowerCase();
+	void trim();
+	void remove(unsigned int index);
+	void remove(unsigned int index, unsigned int count);
+
+private:
+	char* _buf;
+	unsigned int _capacity;
+	unsigned int _len;
+};
+
+class Print;
+
+class Printable {
+public:
+	virtual ~Printable() {}
+	virtual size_t printTo(Print& p) const = 0;
+};
+
+class Print {
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t* data, size_t len);
+	size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+	size_t print(const char* s) { return write(s); }
+	size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(unsigned int value);
+	size_t print(int value);
+	size_t print(unsigned long value) { return print((unsigned int)value); }
+	size_t print(long value) { return print((int)value); }
+	size_t print(const Printable& value) { return value.printTo(*this); }
+	size_t println(const char* s = "") { return print(s) + print("\r\n"); }
+	size_t println(const String& s) { return print(s) + print("\r\n"); }
+	size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+// output goes to stdout
+class HardwareSerial : public Print {
+public:
+	void begin(unsigned long baud) {}
+	void setDebugOutput(bool enable) {}
+	operator bool() const { return true; }
+	virtual size_t write(uint8_t c) override;
+	virtual size_t write(const uint8_t* data, size_t len) override;
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+	uint32_t getFreeHeap();
+	uint32_t getMaxFreeBlockSize();
+	uint8_t getHeapFragmentation() { return 0; }
+	uint32_t getChipId() { return 0x00c0ffee; }
+	uint32_t getFlashChipRealSize() { return 4 * 1024 * 1024; }
+	uint32_t getSketchSize() { return 400 * 1024; }
+	uint32_t getFreeSketchSpace() { return 1024 * 1024; }
+	void restart();
+	uint32_t hostRestarts = 0;
+};
+extern EspClass ESP;
+
+#endif // _HOST_ARDUINO_h
@@ -0,0 +1,35 @@
+// ArduinoOTA.h - host stand-in, never receives an upload
+
+#ifndef _HOST_ARDUINOOTA_h
+#define _HOST_ARDUINOOTA_h
+
+#include "Arduino.h"
+#include "Updater.h"
+
+typedef enum {
+	OTA_AUTH_ERROR,
+	OTA_BEGIN_ERROR,
+	OTA_CONNECT_ERROR,
+	OTA_RECEIVE_ERROR,
+	OTA_END_ERROR
+} ota_error_t;
+
+class ArduinoOTAClass {
+public:
+	typedef std::function<void(void)> THandlerFunction;
+	typedef std::function<void(ota_error_t)> THandlerFunction_Error;
+	typedef std::function<void(unsigned int, unsigned int)> THandlerFunction_Progress;
+
+	void setPort(uint16_t port) {}
+	void setHostname(const char* hostname) {}
+	void setPassword(const char* password) {}
+	void onStart(THandlerFunction fn) {}
+	void onEnd(THandlerFunction fn) {}
+	void onError(THandlerFunction_Error fn) {}
+	void onProgress(THandlerFunction_Progress fn) {}
+	void begin() {}
+	void handle() {}
+};
+extern ArduinoOTAClass ArduinoOTA;
+
+#endif // _HOST_ARDUINOOTA_h
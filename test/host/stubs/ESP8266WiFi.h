@@ -0,0 +1,107 @@
+// ESP8266WiFi.h - host stand-in, a station that is connected from the start
+
+#ifndef _HOST_ESP8266WIFI_h
+#define _HOST_ESP8266WIFI_h
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+typedef enum {
+	WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3
+} WiFiMode_t;
+
+typedef enum {
+	WL_IDLE_STATUS = 0,
+	WL_NO_SSID_AVAIL = 1,
+	WL_SCAN_COMPLETED = 2,
+	WL_CONNECTED = 3,
+	WL_CONNECT_FAILED = 4,
+	WL_CONNECTION_LOST = 5,
+	WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum {
+	WIFI_DISCONNECT_REASON_UNSPECIFIED = 1
+} WiFiDisconnectReason;
+
+struct WiFiEventStationModeConnected {
+	String ssid;
+	uint8_t bssid[6];
+	uint8_t channel;
+};
+
+struct WiFiEventStationModeDisconnected {
+	String ssid;
+	uint8_t bssid[6];
+	WiFiDisconnectReason reason;
+};
+
+struct WiFiEventStationModeGotIP {
+	IPAddress ip;
+	IPAddress mask;
+	IPAddress gw;
+};
+
+struct WiFiEventSoftAPModeStationConnected {
+	uint8_t mac[6];
+	uint8_t aid;
+};
+
+struct WiFiEventSoftAPModeStationDisconnected {
+	uint8_t mac[6];
+	uint8_t aid;
+};
+
+class WiFiEventHandlerOpaque {};
+typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
+
+// user_interface.h
+struct station_config {
+	uint8_t ssid[32];
+	uint8_t password[64];
+	uint8_t bssid_set;
+	uint8_t bssid[6];
+};
+bool wifi_station_get_config(struct station_config* config);
+
+class ESP8266WiFiClass {
+public:
+	void persistent(bool persistent) {}
+	bool mode(WiFiMode_t mode) { _mode = mode; return true; }
+	wl_status_t begin(const char* ssid, const char* passphrase = NULL, int32_t channel = 0, const uint8_t* bssid = NULL, bool connect = true);
+	bool config(IPAddress local_ip, IPAddress gateway, IPAddress subnet, IPAddress dns1 = (uint32_t)0, IPAddress dns2 = (uint32_t)0) { return true; }
+	bool disconnect(bool wifioff = false) { return true; }
+	bool softAP(const char* ssid, const char* passphrase = NULL, int channel = 1, int ssid_hidden = 0, int max_connection = 4) { return true; }
+	bool hostname(const char* name) { return true; }
+	wl_status_t status() { return WL_CONNECTED; }
+	IPAddress localIP() { return IPAddress(192, 168, 1, 50); }
+	IPAddress gatewayIP() { return IPAddress(192, 168, 1, 1); }
+	IPAddress subnetMask() { return IPAddress(255, 255, 255, 0); }
+	IPAddress dnsIP(uint8_t dns_no = 0) { return IPAddress(192, 168, 1, 1); }
+	uint8_t* macAddress(uint8_t* mac);
+	uint8_t* BSSID() { return _bssid; }
+	int32_t channel() { return 6; }
+
+	WiFiEventHandler onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> f) { return WiFiEventHandler(); }
+	WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> f) { return WiFiEventHandler(); }
+	WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> f) { return WiFiEventHandler(); }
+	WiFiEventHandler onSoftAPModeStationConnected(std::function<void(const WiFiEventSoftAPModeStationConnected&)> f) { return WiFiEventHandler(); }
+	WiFiEventHandler onSoftAPModeStationDisconnected(std::function<void(const WiFiEventSoftAPModeStationDisconnected&)> f) { return WiFiEventHandler(); }
+
+	// scans find nothing
+	void scanNetworksAsync(std::function<void(int)> onComplete, bool show_hidden = false) { onComplete(0); }
+	void scanDelete() {}
+	String SSID(uint8_t i) { return String(); }
+	int32_t RSSI(uint8_t i) { return 0; }
+	uint8_t encryptionType(uint8_t i) { return 0; }
+	bool isHidden(uint8_t i) { return false; }
+	uint8_t* BSSID(uint8_t i) { return _bssid; }
+	int32_t channel(uint8_t i) { return 6; }
+
+private:
+	WiFiMode_t _mode = WIFI_STA;
+	uint8_t _bssid[6] = { 0 };
+};
+extern ESP8266WiFiClass WiFi;
+
+#endif // _HOST_ESP8266WIFI_h
@@ -0,0 +1,15 @@
+// ESP8266mDNS.h - host stand-in
+
+#ifndef _HOST_ESP8266MDNS_h
+#define _HOST_ESP8266MDNS_h
+
+#include "Arduino.h"
+
+class MDNSResponder {
+public:
+	bool begin(const char* hostName) { return true; }
+	void addService(const char* service, const char* proto, uint16_t port) {}
+};
+extern MDNSResponder MDNS;
+
+#endif // _HOST_ESP8266MDNS_h
@@ -0,0 +1,83 @@
+// ESPAsyncTCP.h - host stand-in. Nothing goes over the network: tests open
+// and close connections and feed received data by hand, the ack rules are
+// the ones of the real AsyncClient (see hostReceive()).
+
+#ifndef _HOST_ESPASYNCTCP_h
+#define _HOST_ESPASYNCTCP_h
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "lwip/tcp.h"
+#include <string>
+
+class AsyncClient;
+
+typedef std::function<void(void*, AsyncClient*)> AcConnectHandler;
+typedef std::function<void(void*, AsyncClient*, size_t len, uint32_t time)> AcAckHandler;
+typedef std::function<void(void*, AsyncClient*, int8_t error)> AcErrorHandler;
+typedef std::function<void(void*, AsyncClient*, void* data, size_t len)> AcDataHandler;
+typedef std::function<void(void*, AsyncClient*, uint32_t time)> AcTimeoutHandler;
+
+class AsyncClient {
+public:
+	AsyncClient() {}
+	~AsyncClient();
+
+	bool connect(const char* host, uint16_t port);
+	bool connected() const { return _open; }
+	void close(bool now = false);
+	void stop() { close(false); }
+	size_t write(const char* data);
+	size_t write(const char* data, size_t size, uint8_t apiflags = 0);
+	size_t ack(size_t len);
+	void ackLater() { _ackNow = false; }
+	void setNoDelay(bool nodelay) { _noDelay = nodelay; }
+	bool getNoDelay() { return _noDelay; }
+	void setRxTimeout(uint32_t timeout) {}
+
+	uint32_t getRemoteAddress() const { return _pcb.remote_ip.addr; }
+	uint16_t getRemotePort() const { return _pcb.remote_port; }
+	uint16_t getLocalPort() const { return _pcb.local_port; }
+	IPAddress remoteIP() const { return IPAddress(getRemoteAddress()); }
+
+	void onConnect(AcConnectHandler cb, void* arg = 0) { _connectCb = cb; _connectArg = arg; }
+	void onDisconnect(AcConnectHandler cb, void* arg = 0) { _discardCb = cb; _discardArg = arg; }
+	void onAck(AcAckHandler cb, void* arg = 0) {}
+	void onError(AcErrorHandler cb, void* arg = 0) { _errorCb = cb; _errorArg = arg; }
+	void onData(AcDataHandler cb, void* arg = 0) { _dataCb = cb; _dataArg = arg; }
+	void onTimeout(AcTimeoutHandler cb, void* arg = 0) {}
+
+	// host side
+	void hostAccept(uint32_t remoteIP, uint16_t remotePort, uint16_t localPort); // incoming connection
+	void hostConnected(); // outgoing connect() succeeded
+	void hostFailed(int8_t error); // outgoing connect() failed
+	void hostReceive(const void* data, size_t len); // one segment
+	void hostPoll(); // carries out a close() requested from a callback
+	void hostRemoteClose(); // the peer closed the connection
+	std::string hostSent; // everything written
+	String hostHost; // of the last connect()
+	size_t hostAcked = 0; // bytes acked to the peer (window opened)
+	size_t hostReceived = 0;
+	bool hostConnecting = false;
+
+private:
+	struct tcp_pcb _pcb = {};
+	bool _open = false;
+	bool _closePending = false;
+	bool _ackNow = true;
+	size_t _rxAckLen = 0; // received, left to ack() because of ackLater()
+	bool _noDelay = false;
+	AcConnectHandler _connectCb;
+	void* _connectArg = NULL;
+	AcConnectHandler _discardCb;
+	void* _discardArg = NULL;
+	AcErrorHandler _errorCb;
+	void* _errorArg = NULL;
+	AcDataHandler _dataCb;
+	void* _dataArg = NULL;
+	void link();
+	void unlink();
+	void closeNow();
+};
+
+#endif // _HOST_ESPASYNCTCP_h
@@ -0,0 +1,174 @@
+#include "ESPAsyncWebServer.h"
+
+static const String emptyString;
+
+const AsyncWebHeader* AsyncWebServerResponse::hostHeader(const char* name) const {
+	const AsyncWebHeader* found = NULL;
+	for (size_t i = 0; i < _headers.size(); i++) {
+		if (strcasecmp(_headers[i].name().c_str(), name) == 0) found = &_headers[i];
+	}
+	return found;
+}
+
+size_t AsyncWebServerResponse::hostHeaderCount(const char* name) const {
+	size_t count = 0;
+	for (size_t i = 0; i < _headers.size(); i++) {
+		if (strcasecmp(_headers[i].name().c_str(), name) == 0) count++;
+	}
+	return count;
+}
+
+AsyncBasicResponse::AsyncBasicResponse(int code, const String& contentType, const String& content) : _content(content) {
+	_code = code;
+	_contentType = contentType;
+	_contentLength = _content.length();
+	if (_contentLength && !_contentType.length()) _contentType = "text/plain";
+}
+
+std::string AsyncAbstractResponse::hostBody() {
+	std::string body;
+	uint8_t buf[hostSegment];
+	for (;;) {
+		size_t n = _fillBuffer(buf, sizeof(buf));
+		if (!n) break;
+		body.append((const char*)buf, n);
+	}
+	return body;
+}
+
+// like the real one: the .gz variant is picked when only that exists
+AsyncFileResponse::AsyncFileResponse(FS& fs, const String& path, const String& contentType, bool download) {
+	_code = 200;
+	String name = path;
+	if (!download && !fs.exists(name) && fs.exists(name + ".gz")) {
+		name += ".gz";
+		addHeader("Content-Encoding", "gzip");
+	}
+	_content = fs.open(name, "r");
+	_contentLength = _content.size();
+	_contentType = contentType;
+}
+
+AsyncChunkedResponse::AsyncChunkedResponse(const String& contentType, AwsResponseFiller callback) : _callback(callback) {
+	_code = 200;
+	_contentType = contentType;
+	_contentLength = 0;
+}
+
+// the real response also leaves room for the chunk header and trailer
+size_t AsyncChunkedResponse::_fillBuffer(uint8_t* buf, size_t maxLen) {
+	if (maxLen <= 8) return 0;
+	size_t n = _callback(buf, maxLen - 8, _filled);
+	_filled += n;
+	return n;
+}
+
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer* server, AsyncClient* client, WebRequestMethodComposite method, const String& url) : _server(server), _client(client), _method(method), _url(url) {}
+
+AsyncWebServerRequest::~AsyncWebServerRequest() {
+	delete _response;
+	if (_tempObject) free(_tempObject);
+	if (_tempFile) _tempFile.close();
+}
+
+AsyncWebHeader* AsyncWebServerRequest::getHeader(const String& name) const {
+	for (size_t i = 0; i < _headers.size(); i++) {
+		if (strcasecmp(_headers[i].name().c_str(), name.c_str()) == 0) return const_cast<AsyncWebHeader*>(&_headers[i]);
+	}
+	return NULL;
+}
+
+AsyncWebParameter* AsyncWebServerRequest::getParam(const String& name, bool post, bool file) const {
+	for (size_t i = 0; i < _params.size(); i++) {
+		const AsyncWebParameter& p = _params[i];
+		if ((p.name() == name) && (p.isPost() == post) && (p.isFile() == file)) return const_cast<AsyncWebParameter*>(&p);
+	}
+	return NULL;
+}
+
+const String& AsyncWebServerRequest::arg(const String& name) const {
+	for (size_t i = 0; i < _params.size(); i++) {
+		if (_params[i].name() == name) return _params[i].value();
+	}
+	return emptyString;
+}
+
+const String& AsyncWebServerRequest::arg(size_t i) const {
+	return (i < _params.size()) ? _params[i].value() : emptyString;
+}
+
+const String& AsyncWebServerRequest::argName(size_t i) const {
+	return (i < _params.size()) ? _params[i].name() : emptyString;
+}
+
+bool AsyncWebServerRequest::hasArg(const char* name) const {
+	for (size_t i = 0; i < _params.size(); i++) {
+		if (_params[i].name() == name) return true;
+	}
+	return false;
+}
+
+static String base64(const String& in) {
+	static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	String out;
+	const uint8_t* p = (const uint8_t*)in.c_str();
+	size_t len = in.length();
+	for (size_t i = 0; i < len; i += 3) {
+		uint32_t v = p[i] << 16;
+		if (i + 1 < len) v |= p[i + 1] << 8;
+		if (i + 2 < len) v |= p[i + 2];
+		out += table[(v >> 18) & 63];
+		out += table[(v >> 12) & 63];
+		out += (i + 1 < len) ? table[(v >> 6) & 63] : '=';
+		out += (i + 2 < len) ? table[v & 63] : '=';
+	}
+	return out;
+}
+
+// basic auth only
+bool AsyncWebServerRequest::authenticate(const char* username, const char* password, const char* realm, bool passwordIsHash) {
+	AsyncWebHeader* auth = getHeader("Authorization");
+	if (!auth) return false;
+	return auth->value() == "Basic " + base64(String(username) + ":" + password);
+}
+
+void AsyncWebServerRequest::requestAuthentication(const char* realm, bool isDigest) {
+	AsyncWebServerResponse* response = beginResponse(401);
+	response->addHeader("WWW-Authenticate", String("Basic realm=\"") + (realm ? realm : "Login Required") + "\"");
+	send(response);
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse* response) {
+	_response = response;
+	if (!_response->_sourceValid()) {
+		delete response;
+		_response = NULL;
+		send(500);
+	}
+}
+
+void AsyncWebServer::hostAttach(AsyncWebServerRequest* request) {
+	for (size_t i = 0; i < _handlers.size(); i++) {
+		if (_handlers[i]->filter(request) && _handlers[i]->canHandle(request)) {
+			request->_handler = _handlers[i];
+			return;
+		}
+	}
+}
+
+void AsyncWebServer::hostUpload(AsyncWebServerRequest* request, const String& filename, const uint8_t* data, size_t len, size_t chunk) {
+	request->_params.push_back(AsyncWebParameter("data", filename, true, true, len));
+	if (!request->_handler) return;
+	size_t index = 0;
+	do {
+		size_t n = (len - index < chunk) ? len - index : chunk;
+		request->_handler->handleUpload(request, filename, index, const_cast<uint8_t*>(data + index), n, index + n == len);
+		index += n;
+	} while (index < len);
+}
+
+void AsyncWebServer::hostHandle(AsyncWebServerRequest* request) {
+	if (request->_handler) request->_handler->handleRequest(request);
+	else if (_notFound) _notFound(request);
+	else request->send(404);
+}
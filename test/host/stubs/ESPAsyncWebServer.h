@@ -0,0 +1,231 @@
+// ESPAsyncWebServer.h - host stand-in with the handler dispatch of the real
+// server. Tests build a request, run it through hostAttach(), hostUpload()
+// and hostHandle() the way the parser would, then look at the response.
+// Responses are not streamed, hostBody() pulls the whole body at once.
+
+#ifndef _HOST_ESPASYNCWEBSERVER_h
+#define _HOST_ESPASYNCWEBSERVER_h
+
+#include "Arduino.h"
+#include "FS.h"
+#include "ESPAsyncTCP.h"
+#include <string>
+#include <vector>
+
+typedef enum {
+	HTTP_GET = 0b00000001,
+	HTTP_POST = 0b00000010,
+	HTTP_DELETE = 0b00000100,
+	HTTP_PUT = 0b00001000,
+	HTTP_PATCH = 0b00010000,
+	HTTP_HEAD = 0b00100000,
+	HTTP_OPTIONS = 0b01000000,
+	HTTP_ANY = 0b01111111
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+class AsyncWebHandler;
+
+typedef std::function<void(AsyncWebServerRequest* request)> ArRequestHandlerFunction;
+typedef std::function<size_t(uint8_t*, size_t, size_t)> AwsResponseFiller;
+
+class AsyncWebHeader {
+public:
+	AsyncWebHeader(const String& name, const String& value) : _name(name), _value(value) {}
+	const String& name() const { return _name; }
+	const String& value() const { return _value; }
+private:
+	String _name;
+	String _value;
+};
+
+class AsyncWebParameter {
+public:
+	AsyncWebParameter(const String& name, const String& value, bool form = false, bool file = false, size_t size = 0) : _name(name), _value(value), _size(size), _isForm(form), _isFile(file) {}
+	const String& name() const { return _name; }
+	const String& value() const { return _value; }
+	size_t size() const { return _size; }
+	bool isPost() const { return _isForm; }
+	bool isFile() const { return _isFile; }
+private:
+	String _name;
+	String _value;
+	size_t _size;
+	bool _isForm;
+	bool _isFile;
+};
+
+class AsyncWebServerResponse {
+public:
+	AsyncWebServerResponse() : _code(0), _contentLength(0) {}
+	virtual ~AsyncWebServerResponse() {}
+	void setCode(int code) { _code = code; }
+	void setContentLength(size_t len) { _contentLength = len; }
+	void setContentType(const String& type) { _contentType = type; }
+	void addHeader(const String& name, const String& value) { _headers.push_back(AsyncWebHeader(name, value)); }
+	virtual bool _sourceValid() const { return false; }
+
+	// host side
+	int hostCode() const { return _code; }
+	const String& hostContentType() const { return _contentType; }
+	const AsyncWebHeader* hostHeader(const char* name) const; // last one with that name
+	size_t hostHeaderCount(const char* name) const;
+	virtual std::string hostBody() { return std::string(); }
+
+protected:
+	int _code;
+	std::vector<AsyncWebHeader> _headers;
+	String _contentType;
+	size_t _contentLength;
+};
+
+class AsyncBasicResponse : public AsyncWebServerResponse {
+public:
+	AsyncBasicResponse(int code, const String& contentType = String(), const String& content = String());
+	virtual bool _sourceValid() const override { return true; }
+	virtual std::string hostBody() override { return _content.c_str(); }
+private:
+	String _content;
+};
+
+class AsyncAbstractResponse : public AsyncWebServerResponse {
+public:
+	virtual bool _sourceValid() const override { return false; }
+	virtual size_t _fillBuffer(uint8_t* buf, size_t maxLen) { return 0; }
+	virtual std::string hostBody() override; // in TCP_MSS pieces like _ack() asks for them
+	static const size_t hostSegment = 1460;
+};
+
+class AsyncFileResponse : public AsyncAbstractResponse {
+public:
+	AsyncFileResponse(FS& fs, const String& path, const String& contentType = String(), bool download = false);
+	virtual bool _sourceValid() const override { return !!_content; }
+	virtual size_t _fillBuffer(uint8_t* buf, size_t maxLen) override { return _content.read(buf, maxLen); }
+private:
+	File _content;
+};
+
+class AsyncChunkedResponse : public AsyncAbstractResponse {
+public:
+	AsyncChunkedResponse(const String& contentType, AwsResponseFiller callback);
+	virtual bool _sourceValid() const override { return !!_callback; }
+	virtual size_t _fillBuffer(uint8_t* buf, size_t maxLen) override;
+private:
+	AwsResponseFiller _callback;
+	size_t _filled = 0;
+};
+
+class AsyncWebServerRequest {
+	friend class AsyncWebServer;
+public:
+	File _tempFile;
+	void* _tempObject = NULL;
+
+	// host side: what the parser would have filled in
+	AsyncWebServerRequest(AsyncWebServer* server, AsyncClient* client, WebRequestMethodComposite method, const String& url);
+	~AsyncWebServerRequest();
+	void hostHeader(const String& name, const String& value) { _headers.push_back(AsyncWebHeader(name, value)); }
+	void hostParam(const String& name, const String& value, bool post = false, bool file = false, size_t size = 0) { _params.push_back(AsyncWebParameter(name, value, post, file, size)); }
+	void hostContentLength(size_t len) { _contentLength = len; }
+	AsyncWebServerResponse* hostResponse() const { return _response; }
+	AsyncWebHandler* hostHandler() const { return _handler; }
+
+	AsyncClient* client() { return _client; }
+	WebRequestMethodComposite method() const { return _method; }
+	const String& url() const { return _url; }
+	size_t contentLength() const { return _contentLength; }
+
+	bool hasHeader(const String& name) const { return getHeader(name) != NULL; }
+	AsyncWebHeader* getHeader(const String& name) const;
+	void addInterestingHeader(const String& name) {}
+
+	size_t params() const { return _params.size(); }
+	bool hasParam(const String& name, bool post = false, bool file = false) const { return getParam(name, post, file) != NULL; }
+	AsyncWebParameter* getParam(const String& name, bool post = false, bool file = false) const;
+	AsyncWebParameter* getParam(size_t num) const { return (num < _params.size()) ? const_cast<AsyncWebParameter*>(&_params[num]) : NULL; }
+	size_t args() const { return params(); }
+	const String& arg(const String& name) const;
+	const String& arg(size_t i) const;
+	const String& argName(size_t i) const;
+	bool hasArg(const char* name) const;
+
+	bool authenticate(const char* username, const char* password, const char* realm = NULL, bool passwordIsHash = false);
+	void requestAuthentication(const char* realm = NULL, bool isDigest = true);
+
+	void send(AsyncWebServerResponse* response);
+	void send(int code, const String& contentType = String(), const String& content = String()) { send(beginResponse(code, contentType, content)); }
+	void send_P(int code, const String& contentType, PGM_P content) { send(beginResponse(code, contentType, String(content))); }
+	AsyncWebServerResponse* beginResponse(int code, const String& contentType = String(), const String& content = String()) { return new AsyncBasicResponse(code, contentType, content); }
+	AsyncWebServerResponse* beginResponse(FS& fs, const String& path, const String& contentType = String(), bool download = false) { return new AsyncFileResponse(fs, path, contentType, download); }
+	AsyncWebServerResponse* beginChunkedResponse(const String& contentType, AwsResponseFiller callback) { return new AsyncChunkedResponse(contentType, callback); }
+
+private:
+	AsyncWebServer* _server;
+	AsyncClient* _client;
+	WebRequestMethodComposite _method;
+	String _url;
+	size_t _contentLength = 0;
+	std::vector<AsyncWebHeader> _headers;
+	std::vector<AsyncWebParameter> _params;
+	AsyncWebHandler* _handler = NULL;
+	AsyncWebServerResponse* _response = NULL;
+};
+
+class AsyncWebHandler {
+public:
+	virtual ~AsyncWebHandler() {}
+	virtual bool filter(AsyncWebServerRequest* request) { return true; }
+	virtual bool canHandle(AsyncWebServerRequest* request) { return false; }
+	virtual void handleRequest(AsyncWebServerRequest* request) {}
+	virtual void handleUpload(AsyncWebServerRequest* request, const String& filename, size_t index, uint8_t* data, size_t len, bool final) {}
+	virtual void handleBody(AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {}
+	virtual bool isRequestHandlerTrivial() { return true; }
+};
+
+class AsyncEventSourceClient {
+public:
+	AsyncClient* client() { return _client; }
+private:
+	AsyncClient* _client = NULL;
+};
+
+typedef std::function<void(AsyncEventSourceClient* client)> ArEventHandlerFunction;
+
+// takes no clients, sent events are only counted
+class AsyncEventSource : public AsyncWebHandler {
+public:
+	AsyncEventSource(const String& url) : _url(url) {}
+	void onConnect(ArEventHandlerFunction cb) { _connectcb = cb; }
+	void send(const char* message, const char* event = NULL, uint32_t id = 0, uint32_t reconnect = 0) { hostEvents++; }
+	size_t count() const { return 0; }
+	size_t avgPacketsWaiting() const { return 0; }
+	virtual bool canHandle(AsyncWebServerRequest* request) override { return (request->method() == HTTP_GET) && (request->url() == _url); }
+	virtual void handleRequest(AsyncWebServerRequest* request) override { request->send(200, "text/event-stream"); }
+	uint32_t hostEvents = 0;
+private:
+	String _url;
+	ArEventHandlerFunction _connectcb;
+};
+
+class AsyncWebServer {
+public:
+	AsyncWebServer(uint16_t port) {}
+	virtual ~AsyncWebServer() {}
+	void begin() {}
+	AsyncWebHandler& addHandler(AsyncWebHandler* handler) { _handlers.push_back(handler); return *handler; }
+	void onNotFound(ArRequestHandlerFunction fn) { _notFound = fn; }
+
+	// host side, the steps of AsyncWebServerRequest::_parseLine() and _parseReqBody()
+	void hostAttach(AsyncWebServerRequest* request); // headers complete => first handler that canHandle()
+	void hostUpload(AsyncWebServerRequest* request, const String& filename, const uint8_t* data, size_t len, size_t chunk); // multipart file part
+	void hostHandle(AsyncWebServerRequest* request); // body complete
+
+private:
+	std::vector<AsyncWebHandler*> _handlers;
+	ArRequestHandlerFunction _notFound;
+};
+
+#endif // _HOST_ESPASYNCWEBSERVER_h
@@ -0,0 +1,124 @@
+#include "FS.h"
+#include "TimeLib.h"
+
+fs::FS SPIFFS;
+
+namespace fs {
+
+File::File(const String& name, HostFilePtr data, bool writable) : _name(name), _data(data), _writable(writable) {}
+
+size_t File::write(const uint8_t* buf, size_t size) {
+	if (!_data || !_writable) return 0;
+	_data->content.replace(_pos, size, (const char*)buf, size);
+	_pos += size;
+	_data->mtime = now();
+	return size;
+}
+
+int File::read() {
+	uint8_t c;
+	return read(&c, 1) ? c : -1;
+}
+
+size_t File::read(uint8_t* buf, size_t size) {
+	if (!_data) return 0;
+	size_t n = _data->content.size() - _pos;
+	if (n > size) n = size;
+	memcpy(buf, _data->content.data() + _pos, n);
+	_pos += n;
+	return n;
+}
+
+bool File::seek(uint32_t pos, SeekMode mode) {
+	if (!_data) return false;
+	if (mode == SeekCur) pos += _pos;
+	else if (mode == SeekEnd) pos = _data->content.size() - pos;
+	if (pos > _data->content.size()) return false;
+	_pos = pos;
+	return true;
+}
+
+// in name order, files added or removed meanwhile are seen like SPIFFS would
+bool Dir::next() {
+	if (_done) return false;
+	std::map<std::string, HostFilePtr>::iterator it = _started ? _fs->_files.upper_bound(_name) : _fs->_files.lower_bound(_prefix.c_str());
+	_started = true;
+	_done = (it == _fs->_files.end()) || (it->first.compare(0, _prefix.length(), _prefix.c_str()) != 0);
+	if (!_done) _name = it->first;
+	return !_done;
+}
+
+size_t Dir::fileSize() {
+	std::map<std::string, HostFilePtr>::iterator it = _fs->_files.find(_name);
+	return (it != _fs->_files.end()) ? it->second->content.size() : 0;
+}
+
+time_t Dir::fileTime() {
+	std::map<std::string, HostFilePtr>::iterator it = _fs->_files.find(_name);
+	return (it != _fs->_files.end()) ? it->second->mtime : 0;
+}
+
+File Dir::openFile(const char* mode) {
+	return _fs->open(_name.c_str(), mode);
+}
+
+bool FS::info(FSInfo& info) {
+	memset(&info, 0, sizeof(info));
+	info.totalBytes = hostTotalBytes;
+	for (std::map<std::string, HostFilePtr>::iterator it = _files.begin(); it != _files.end(); ++it) {
+		info.usedBytes += it->second->content.size();
+	}
+	info.blockSize = 8192;
+	info.pageSize = 256;
+	info.maxOpenFiles = 5;
+	info.maxPathLength = 32;
+	return true;
+}
+
+File FS::open(const char* path, const char* mode) {
+	hostOpens++;
+	std::map<std::string, HostFilePtr>::iterator it = _files.find(path);
+	if (mode[0] == 'r') {
+		if (it == _files.end()) return File();
+		return File(path, it->second, mode[1] == '+');
+	}
+	HostFilePtr data = (it != _files.end()) ? it->second : std::make_shared<HostFileData>();
+	if (mode[0] == 'w') data->content.clear();
+	data->mtime = now();
+	_files[path] = data;
+	File file(path, data, true);
+	if (mode[0] == 'a') file.seek(0, SeekEnd);
+	return file;
+}
+
+bool FS::exists(const char* path) {
+	hostOpens++;
+	return _files.count(path) > 0;
+}
+
+bool FS::remove(const char* path) {
+	return _files.erase(path) > 0;
+}
+
+bool FS::rename(const char* pathFrom, const char* pathTo) {
+	std::map<std::string, HostFilePtr>::iterator it = _files.find(pathFrom);
+	if ((it == _files.end()) || _files.count(pathTo)) return false;
+	HostFilePtr data = it->second;
+	_files.erase(it);
+	_files[pathTo] = data;
+	return true;
+}
+
+void FS::hostWrite(const char* path, const std::string& content, time_t mtime) {
+	HostFilePtr data = std::make_shared<HostFileData>();
+	data->content = content;
+	data->mtime = mtime;
+	_files[path] = data;
+}
+
+std::string FS::hostRead(const char* path) {
+	std::map<std::string, HostFilePtr>::iterator it = _files.find(path);
+	return (it != _files.end()) ? it->second->content : std::string();
+}
+
+} // namespace fs
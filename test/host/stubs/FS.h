@@ -0,0 +1,116 @@
+// FS.h - host stand-in: a flat in-memory filesystem with SPIFFS semantics
+// (full paths as names, no directories, "w" truncates)
+
+#ifndef _HOST_FS_h
+#define _HOST_FS_h
+
+#include "Arduino.h"
+#include <map>
+#include <string>
+
+namespace fs {
+
+enum SeekMode {
+	SeekSet = 0,
+	SeekCur = 1,
+	SeekEnd = 2
+};
+
+struct FSInfo {
+	size_t totalBytes;
+	size_t usedBytes;
+	size_t blockSize;
+	size_t pageSize;
+	size_t maxOpenFiles;
+	size_t maxPathLength;
+};
+
+struct HostFileData {
+	std::string content;
+	time_t mtime = 0;
+};
+typedef std::shared_ptr<HostFileData> HostFilePtr;
+
+class File : public Print {
+public:
+	File() {}
+	File(const String& name, HostFilePtr data, bool writable);
+	virtual size_t write(uint8_t c) override { return write(&c, 1); }
+	virtual size_t write(const uint8_t* buf, size_t size) override;
+	int read();
+	size_t read(uint8_t* buf, size_t size);
+	int available() { return _data ? (int)(_data->content.size() - _pos) : 0; }
+	bool seek(uint32_t pos, SeekMode mode = SeekSet);
+	size_t position() const { return _pos; }
+	size_t size() const { return _data ? _data->content.size() : 0; }
+	void close() { _data.reset(); }
+	operator bool() const { return !!_data; }
+	const char* name() const { return _name.c_str(); }
+	time_t getLastWrite() { return _data ? _data->mtime : 0; }
+private:
+	String _name;
+	HostFilePtr _data;
+	size_t _pos = 0;
+	bool _writable = false;
+};
+
+class FS;
+
+class Dir {
+public:
+	Dir() {}
+	Dir(FS* fs, const String& prefix) : _fs(fs), _prefix(prefix) {}
+	bool next();
+	String fileName() { return String(_name.c_str()); }
+	size_t fileSize();
+	time_t fileTime();
+	File openFile(const char* mode);
+private:
+	FS* _fs = NULL;
+	String _prefix;
+	std::string _name;
+	bool _started = false;
+	bool _done = false;
+};
+
+class FS {
+	friend class Dir;
+public:
+	bool begin() { return true; }
+	void end() {}
+	bool format() { _files.clear(); return true; }
+	bool info(FSInfo& info);
+	File open(const char* path, const char* mode);
+	File open(const String& path, const char* mode) { return open(path.c_str(), mode); }
+	bool exists(const char* path);
+	bool exists(const String& path) { return exists(path.c_str()); }
+	Dir openDir(const char* path) { return Dir(this, path); }
+	Dir openDir(const String& path) { return Dir(this, path); }
+	bool remove(const char* path);
+	bool remove(const String& path) { return remove(path.c_str()); }
+	bool rename(const char* pathFrom, const char* pathTo);
+	bool rename(const String& pathFrom, const String& pathTo) { return rename(pathFrom.c_str(), pathTo.c_str()); }
+
+	// host side
+	void hostWrite(const char* path, const std::string& content, time_t mtime);
+	std::string hostRead(const char* path); // "" if missing
+	size_t hostTotalBytes = 1024 * 1024;
+	uint32_t hostOpens = 0; // open() and exists() calls, each is a SPIFFS lookup
+private:
+	std::map<std::string, HostFilePtr> _files;
+};
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::Dir;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::FSInfo;
+
+extern fs::FS SPIFFS;
+
+#endif // _HOST_FS_h
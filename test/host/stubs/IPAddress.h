@@ -0,0 +1,24 @@
+// IPAddress.h - host stand-in, IPv4 only like the ESP8266 core with lwIP 1.4
+
+#ifndef _HOST_IPADDRESS_h
+#define _HOST_IPADDRESS_h
+
+#include "Arduino.h"
+
+class IPAddress : public Printable {
+public:
+	IPAddress() : _address(0) {}
+	IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _address(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+	IPAddress(uint32_t address) : _address(address) {}
+	operator uint32_t() const { return _address; }
+	uint8_t operator[](int index) const { return (_address >> (8 * index)) & 0xFF; }
+	bool operator==(const IPAddress& other) const { return _address == other._address; }
+	bool fromString(const char* address);
+	bool fromString(const String& address) { return fromString(address.c_str()); }
+	String toString() const;
+	virtual size_t printTo(Print& p) const override { return p.print(toString()); }
+private:
+	uint32_t _address; // network byte order
+};
+
+#endif // _HOST_IPADDRESS_h
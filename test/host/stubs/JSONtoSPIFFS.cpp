@@ -0,0 +1,78 @@
+#include "JSONtoSPIFFS.h"
+
+std::string JSONtoSPIFFS::fullPath(const char* name) {
+	return (name[0] == '/') ? std::string(name) : "/" + std::string(name);
+}
+
+// a missing file is created on save
+bool JSONtoSPIFFS::loadConfigFile(const char* name) {
+	if (!_fs) return false;
+	_path = fullPath(name);
+	_values.clear();
+	std::string json = _fs->hostRead(_path.c_str());
+	size_t pos = 0;
+	for (;;) {
+		size_t keyStart = json.find('"', pos);
+		if (keyStart == std::string::npos) break;
+		size_t keyEnd = json.find('"', keyStart + 1);
+		size_t valueStart = json.find('"', keyEnd + 1);
+		size_t valueEnd = json.find('"', valueStart + 1);
+		if (valueEnd == std::string::npos) break;
+		_values[json.substr(keyStart + 1, keyEnd - keyStart - 1)] = json.substr(valueStart + 1, valueEnd - valueStart - 1);
+		pos = valueEnd + 1;
+	}
+	return true;
+}
+
+bool JSONtoSPIFFS::saveConfigFile() {
+	if (!_fs || _path.empty()) return false;
+	std::string json = "{";
+	for (std::map<std::string, std::string>::iterator it = _values.begin(); it != _values.end(); ++it) {
+		if (json.size() > 1) json += ",";
+		json += "\"" + it->first + "\":\"" + it->second + "\"";
+	}
+	json += "}";
+	File file = _fs->open(_path.c_str(), "w");
+	if (!file) return false;
+	bool okay = file.write((const uint8_t*)json.data(), json.size()) == json.size();
+	file.close();
+	return closeConfigFile() && okay;
+}
+
+bool JSONtoSPIFFS::deleteConfigFile(const char* name) {
+	if (!_fs) return false;
+	std::string path = fullPath(name);
+	return !_fs->exists(path.c_str()) || _fs->remove(path.c_str());
+}
+
+bool JSONtoSPIFFS::getValue(const char* key, String& value) {
+	std::map<std::string, std::string>::iterator it = _values.find(key);
+	if (it == _values.end()) return false;
+	value = it->second.c_str();
+	return true;
+}
+
+bool JSONtoSPIFFS::getValue(const char* key, IPAddress& value) {
+	String s;
+	return getValue(key, s) && value.fromString(s);
+}
+
+bool JSONtoSPIFFS::getValue(const char* key, bool& value) {
+	String s;
+	if (!getValue(key, s)) return false;
+	value = (s == "true");
+	return true;
+}
+
+bool JSONtoSPIFFS::getValue(const char* key, long& value) {
+	String s;
+	if (!getValue(key, s)) return false;
+	value = s.toInt();
+	return true;
+}
+
+bool JSONtoSPIFFS::setValue(const char* key, const String& value) {
+	if (_path.empty()) return false;
+	_values[key] = value.c_str();
+	return true;
+}
@@ -0,0 +1,36 @@
+// JSONtoSPIFFS.h - host stand-in, a flat object of string values
+
+#ifndef _HOST_JSONTOSPIFFS_h
+#define _HOST_JSONTOSPIFFS_h
+
+#include "Arduino.h"
+#include "IPAddress.h"
+#include "FS.h"
+#include <map>
+#include <string>
+
+class JSONtoSPIFFS {
+public:
+	bool begin(FS* fs) { _fs = fs; return true; }
+	bool loadConfigFile(const char* name);
+	bool closeConfigFile() { _values.clear(); _path = ""; return true; }
+	bool saveConfigFile();
+	bool deleteConfigFile(const char* name);
+
+	bool getValue(const char* key, String& value);
+	bool getValue(const char* key, IPAddress& value);
+	bool getValue(const char* key, bool& value);
+	bool getValue(const char* key, long& value);
+	bool setValue(const char* key, const String& value);
+	bool setValue(const char* key, const IPAddress& value) { return setValue(key, value.toString()); }
+	bool setValue(const char* key, bool value) { return setValue(key, String(value ? "true" : "false")); }
+	bool setValue(const char* key, long value) { return setValue(key, String(value)); }
+
+private:
+	FS* _fs = NULL;
+	std::string _path;
+	std::map<std::string, std::string> _values;
+	static std::string fullPath(const char* name);
+};
+
+#endif // _HOST_JSONTOSPIFFS_h
@@ -0,0 +1,23 @@
+// NtpClientLib.h - host stand-in, never syncs
+
+#ifndef _HOST_NTPCLIENTLIB_h
+#define _HOST_NTPCLIENTLIB_h
+
+#include "TimeLib.h"
+
+class NTPClient {
+public:
+	bool begin(String ntpServerName = "pool.ntp.org", int8_t timeOffset = 0, bool daylight = false) { return true; }
+	bool setInterval(int interval) { return true; }
+	bool setInterval(int shortInterval, int longInterval) { return true; }
+	bool setNtpServerName(String ntpServerName) { return true; }
+	bool setTimeZone(int8_t timeZone, int8_t minutes = 0) { return true; }
+	void setDayLight(bool daylight) {}
+	time_t getTime() { return now(); }
+	time_t getLastNTPSync() { return 0; }
+	time_t getUptime() { return millis() / 1000; }
+	time_t getLastBootTime() { return now() - getUptime(); }
+};
+extern NTPClient NTP;
+
+#endif // _HOST_NTPCLIENTLIB_h
@@ -0,0 +1,216 @@
+// Globals and out-of-line parts of the ESP8266 stand-ins
+
+#include "ESP8266WiFi.h"
+#include "ESP8266mDNS.h"
+#include "ESPAsyncTCP.h"
+#include "NtpClientLib.h"
+#include "ArduinoOTA.h"
+#include "Ticker.h"
+#include "lwip/priv/tcp_priv.h"
+
+ESP8266WiFiClass WiFi;
+MDNSResponder MDNS;
+NTPClient NTP;
+ArduinoOTAClass ArduinoOTA;
+UpdaterClass Update;
+struct tcp_pcb* tcp_active_pcbs = NULL;
+
+bool IPAddress::fromString(const char* address) {
+	unsigned int b[4];
+	char tail;
+	if (sscanf(address, "%u.%u.%u.%u%c", &b[0], &b[1], &b[2], &b[3], &tail) != 4) return false;
+	for (int i = 0; i < 4; i++) {
+		if (b[i] > 255) return false;
+	}
+	*this = IPAddress(b[0], b[1], b[2], b[3]);
+	return true;
+}
+
+String IPAddress::toString() const {
+	char buf[16];
+	snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+	return String(buf);
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char* ssid, const char* passphrase, int32_t channel, const uint8_t* bssid, bool connect) {
+	return WL_CONNECTED;
+}
+
+uint8_t* ESP8266WiFiClass::macAddress(uint8_t* mac) {
+	static const uint8_t host[6] = { 0x5c, 0xcf, 0x7f, 0x00, 0x00, 0x01 };
+	memcpy(mac, host, sizeof(host));
+	return mac;
+}
+
+bool wifi_station_get_config(struct station_config* config) {
+	memset(config, 0, sizeof(*config));
+	strcpy((char*)config->ssid, "host");
+	return true;
+}
+
+// time starts at 2020-01-01 and follows millis()
+static time_t hostTimeBase = 1577836800;
+
+time_t now() {
+	return hostTimeBase + millis() / 1000;
+}
+
+void setTime(time_t t) {
+	hostTimeBase = t - millis() / 1000;
+}
+
+static struct tm splitTime(time_t t) {
+	struct tm parts;
+	gmtime_r(&t, &parts);
+	return parts;
+}
+
+int hour(time_t t) { return splitTime(t).tm_hour; }
+int minute(time_t t) { return splitTime(t).tm_min; }
+int second(time_t t) { return splitTime(t).tm_sec; }
+int day(time_t t) { return splitTime(t).tm_mday; }
+int month(time_t t) { return splitTime(t).tm_mon + 1; }
+int year(time_t t) { return splitTime(t).tm_year + 1900; }
+
+void Ticker::arm(float seconds, bool repeat, std::function<void()> callback) {
+	hostSeconds = seconds;
+	_repeat = repeat;
+	_callback = callback;
+}
+
+void Ticker::hostFire() {
+	std::function<void()> callback = _callback;
+	if (!_repeat) _callback = nullptr;
+	if (callback) callback();
+}
+
+bool UpdaterClass::begin(size_t size, int command) {
+	if (!size || (size > ESP.getFreeSketchSpace())) {
+		_error = UPDATE_ERROR_SIZE;
+		return false;
+	}
+	_size = size;
+	_error = UPDATE_ERROR_OK;
+	hostCommand = command;
+	hostWritten = 0;
+	hostWrites = 0;
+	hostFinished = false;
+	return true;
+}
+
+size_t UpdaterClass::write(uint8_t* data, size_t len) {
+	if (!_size || (hostWritten + len > _size)) {
+		_error = UPDATE_ERROR_WRITE;
+		return 0;
+	}
+	hostWritten += len;
+	hostWrites++;
+	return len;
+}
+
+bool UpdaterClass::end(bool evenIfRemaining) {
+	if (!_size) return false;
+	bool okay = evenIfRemaining || (hostWritten == _size);
+	if (!okay) _error = UPDATE_ERROR_SIZE;
+	hostFinished = okay && (hostWritten == _size);
+	_size = 0;
+	return okay;
+}
+
+AsyncClient::~AsyncClient() {
+	unlink();
+}
+
+void AsyncClient::link() {
+	_pcb.next = tcp_active_pcbs;
+	tcp_active_pcbs = &_pcb;
+	_open = true;
+}
+
+void AsyncClient::unlink() {
+	for (struct tcp_pcb** p = &tcp_active_pcbs; *p; p = &(*p)->next) {
+		if (*p == &_pcb) {
+			*p = _pcb.next;
+			break;
+		}
+	}
+	_open = false;
+}
+
+bool AsyncClient::connect(const char* host, uint16_t port) {
+	if (_open || hostConnecting) return false;
+	hostHost = host;
+	hostConnecting = true;
+	_pcb.remote_port = port;
+	return true;
+}
+
+void AsyncClient::hostAccept(uint32_t remoteIP, uint16_t remotePort, uint16_t localPort) {
+	_pcb.remote_ip.addr = remoteIP;
+	_pcb.remote_port = remotePort;
+	_pcb.local_port = localPort;
+	link();
+}
+
+void AsyncClient::hostConnected() {
+	hostConnecting = false;
+	hostSent.clear();
+	hostAcked = 0;
+	hostReceived = 0;
+	_rxAckLen = 0;
+	link();
+	if (_connectCb) _connectCb(_connectArg, this);
+}
+
+void AsyncClient::hostFailed(int8_t error) {
+	hostConnecting = false;
+	if (_errorCb) _errorCb(_errorArg, this, error);
+}
+
+size_t AsyncClient::write(const char* data) {
+	return write(data, strlen(data));
+}
+
+size_t AsyncClient::write(const char* data, size_t size, uint8_t apiflags) {
+	if (!_open) return 0;
+	hostSent.append(data, size);
+	return size;
+}
+
+// ESPAsyncTCP acks a segment after onData returned unless ackLater() was
+// called in there, ack() never acks more than has been received like that
+void AsyncClient::hostReceive(const void* data, size_t len) {
+	if (!_open) return;
+	_ackNow = true;
+	hostReceived += len;
+	if (_dataCb) _dataCb(_dataArg, this, const_cast<void*>(data), len);
+	if (!_ackNow) _rxAckLen += len;
+	else hostAcked += len;
+}
+
+size_t AsyncClient::ack(size_t len) {
+	if (len > _rxAckLen) len = _rxAckLen;
+	_rxAckLen -= len;
+	hostAcked += len;
+	return len;
+}
+
+void AsyncClient::close(bool now) {
+	if (!_open) return;
+	if (now) closeNow();
+	else _closePending = true;
+}
+
+void AsyncClient::hostPoll() {
+	if (_closePending) closeNow();
+}
+
+void AsyncClient::hostRemoteClose() {
+	if (_open) closeNow();
+}
+
+void AsyncClient::closeNow() {
+	_closePending = false;
+	unlink();
+	if (_discardCb) _discardCb(_discardArg, this);
+}
@@ -0,0 +1,8 @@
+// StreamString.h - host stand-in, the library only needs the include
+
+#ifndef _HOST_STREAMSTRING_h
+#define _HOST_STREAMSTRING_h
+
+#include "Arduino.h"
+
+#endif // _HOST_STREAMSTRING_h
@@ -0,0 +1,30 @@
+// Ticker.h - host stand-in, tests fire the callback with hostFire()
+
+#ifndef _HOST_TICKER_h
+#define _HOST_TICKER_h
+
+#include "Arduino.h"
+
+class Ticker {
+public:
+	typedef void (*callback_t)(void);
+	typedef void (*callback_with_arg_t)(void*);
+
+	void attach(float seconds, callback_t callback) { arm(seconds, true, std::bind(callback)); }
+	template<typename TArg> void attach(float seconds, void (*callback)(TArg), TArg arg) { arm(seconds, true, std::bind(callback, arg)); }
+	void once(float seconds, callback_t callback) { arm(seconds, false, std::bind(callback)); }
+	template<typename TArg> void once(float seconds, void (*callback)(TArg), TArg arg) { arm(seconds, false, std::bind(callback, arg)); }
+	void detach() { _callback = nullptr; }
+	bool active() const { return !!_callback; }
+
+	// host side
+	void hostFire();
+	float hostSeconds = 0;
+
+private:
+	std::function<void()> _callback;
+	bool _repeat = false;
+	void arm(float seconds, bool repeat, std::function<void()> callback);
+};
+
+#endif // _HOST_TICKER_h
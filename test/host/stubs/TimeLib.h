@@ -0,0 +1,22 @@
+// TimeLib.h - host stand-in, the clock is millis() based
+
+#ifndef _HOST_TIMELIB_h
+#define _HOST_TIMELIB_h
+
+#include "Arduino.h"
+#include <time.h>
+
+#define SECS_PER_MIN ((time_t)(60UL))
+#define SECS_PER_HOUR ((time_t)(3600UL))
+#define SECS_PER_DAY ((time_t)(SECS_PER_HOUR * 24UL))
+
+time_t now();
+void setTime(time_t t);
+int hour(time_t t);
+int minute(time_t t);
+int second(time_t t);
+int day(time_t t);
+int month(time_t t);
+int year(time_t t);
+
+#endif // _HOST_TIMELIB_h
@@ -0,0 +1,38 @@
+// Updater.h - host stand-in, counts what would be flashed
+
+#ifndef _HOST_UPDATER_h
+#define _HOST_UPDATER_h
+
+#include "Arduino.h"
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+#define UPDATE_ERROR_OK 0
+#define UPDATE_ERROR_WRITE 1
+#define UPDATE_ERROR_SIZE 4
+#define UPDATE_ERROR_MD5 9
+
+class UpdaterClass {
+public:
+	bool begin(size_t size, int command = U_FLASH);
+	void runAsync(bool async) {}
+	bool setMD5(const char* expected_md5) { return true; }
+	size_t write(uint8_t* data, size_t len);
+	bool end(bool evenIfRemaining = false);
+	bool isRunning() { return _size > 0; }
+	uint8_t getError() { return _error; }
+
+	// host side
+	size_t hostWritten = 0;
+	uint32_t hostWrites = 0;
+	int hostCommand = U_FLASH;
+	bool hostFinished = false;
+
+private:
+	size_t _size = 0;
+	uint8_t _error = UPDATE_ERROR_OK;
+};
+extern UpdaterClass Update;
+
+#endif // _HOST_UPDATER_h
@@ -0,0 +1,8 @@
+// WiFiClient.h - host stand-in, the library only needs the include
+
+#ifndef _HOST_WIFICLIENT_h
+#define _HOST_WIFICLIENT_h
+
+#include "ESP8266WiFi.h"
+
+#endif // _HOST_WIFICLIENT_h
@@ -0,0 +1,8 @@
+// lwip/init.h - host stand-in
+
+#ifndef _HOST_LWIP_INIT_h
+#define _HOST_LWIP_INIT_h
+
+#define LWIP_VERSION_MAJOR 2
+
+#endif // _HOST_LWIP_INIT_h
@@ -0,0 +1,10 @@
+// lwip/priv/tcp_priv.h - host stand-in, the mock AsyncClient keeps the list
+
+#ifndef _HOST_LWIP_TCP_PRIV_h
+#define _HOST_LWIP_TCP_PRIV_h
+
+#include "lwip/tcp.h"
+
+extern "C" struct tcp_pcb* tcp_active_pcbs;
+
+#endif // _HOST_LWIP_TCP_PRIV_h
@@ -0,0 +1,21 @@
+// lwip/tcp.h - host stand-in, only what identifies a connection
+
+#ifndef _HOST_LWIP_TCP_h
+#define _HOST_LWIP_TCP_h
+
+#include <stdint.h>
+
+typedef struct {
+	uint32_t addr;
+} ip_addr_t;
+
+#define ip_addr_get_ip4_u32(ipaddr) ((ipaddr)->addr)
+
+struct tcp_pcb {
+	struct tcp_pcb* next;
+	ip_addr_t remote_ip;
+	uint16_t remote_port;
+	uint16_t local_port;
+};
+
+#endif // _HOST_LWIP_TCP_h
@@ -0,0 +1,27 @@
+// test.h - minimal check macros for the host tests
+
+#ifndef _HOST_TEST_h
+#define _HOST_TEST_h
+
+#include <stdio.h>
+
+static int testFailures = 0;
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+		testFailures++; \
+	} \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+	long long _a = (long long)(a), _b = (long long)(b); \
+	if (_a != _b) { \
+		fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+		testFailures++; \
+	} \
+} while (0)
+
+#define TEST_RESULT() (testFailures ? (fprintf(stderr, "%d check(s) failed\n", testFailures), 1) : 0)
+
+#endif // _HOST_TEST_h
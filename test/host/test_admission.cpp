@@ -0,0 +1,75 @@
+// Admission control: slots are held by open connections, not by the request objects
+
+#include "test.h"
+#include "host_server.h"
+
+static HostServer server;
+static fs::FS flash;
+
+static void testLimit() {
+	const uint8_t open = ADMISSION_MAX_REQUESTS - ADMISSION_RESERVED;
+	HostRequest* held[ADMISSION_MAX_REQUESTS];
+	for (uint8_t i = 0; i < open; i++) {
+		held[i] = new HostRequest(server, HTTP_GET, "/index.html");
+		held[i]->attach();
+	}
+	CHECK_EQ(server._admitted.size(), open);
+	//all regular slots taken
+	uint32_t rejected = server._requestsRejected;
+	{
+		HostRequest r(server, HTTP_GET, "/index.html");
+		r.run();
+		CHECK_EQ(r.status(), 503);
+		CHECK(r.responseHeader("Retry-After") == ADMISSION_RETRY_AFTER);
+	}
+	CHECK_EQ(server._requestsRejected, rejected + 1);
+	//event streams are not counted
+	{
+		HostRequest r(server, HTTP_GET, "/events");
+		r.header("Accept", "text/event-stream");
+		r.attach();
+		CHECK_EQ(server._admitted.size(), open);
+	}
+	//the reserved slot is left for /admin
+	held[open] = new HostRequest(server, HTTP_GET, "/admin/log");
+	held[open]->attach();
+	CHECK_EQ(server._admitted.size(), ADMISSION_MAX_REQUESTS);
+	{
+		HostRequest r(server, HTTP_GET, "/admin/log");
+		r.run();
+		CHECK_EQ(r.status(), 503);
+	}
+	//the request objects are gone, the connections still open => still busy
+	for (uint8_t i = 0; i <= open; i++) {
+		held[i]->handle();
+		delete held[i]->request;
+		held[i]->request = new AsyncWebServerRequest(&server, held[i]->client, HTTP_GET, "/unused");
+	}
+	server.handle();
+	CHECK_EQ(server._admitted.size(), ADMISSION_MAX_REQUESTS);
+	//closed connections free their slots in handle()
+	for (uint8_t i = 0; i < 4; i++) delete held[i];
+	server.handle();
+	CHECK_EQ(server._admitted.size(), ADMISSION_MAX_REQUESTS - 4);
+	//... or when a new request finds the table full, before handle() ran
+	for (uint8_t i = 4; i <= open; i++) delete held[i];
+	for (uint8_t i = 0; i < open; i++) {
+		held[i] = new HostRequest(server, HTTP_GET, "/index.html");
+		held[i]->attach();
+	}
+	CHECK_EQ(server._admitted.size(), open);
+	for (uint8_t i = 0; i < open; i++) {
+		held[i]->handle();
+		CHECK_EQ(held[i]->status(), 200);
+		delete held[i];
+	}
+	server.handle();
+	CHECK_EQ(server._admitted.size(), 0);
+}
+
+int main() {
+	flash.hostWrite("/index.html", "<html>index</html>", 1500000000);
+	server.begin(&flash);
+	testLimit();
+	return TEST_RESULT();
+}
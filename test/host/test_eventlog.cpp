@@ -0,0 +1,67 @@
+// EventLog: ring wrap-around, filtering and formatting
+
+#include "EventLog.h"
+#include "test.h"
+
+int main() {
+	EventLog log;
+	char line[EVENTLOG_LINE_LEN];
+
+	//level filter, default is info
+	CHECK(log.enabled(LOG_WIFI, LOG_INFO));
+	CHECK(!log.enabled(LOG_WIFI, LOG_DEBUG));
+	log.add(LOG_WIFI, LOG_DEBUG, "dropped");
+	CHECK_EQ(log.next(), 0);
+	log.setLevel(LOG_WIFI, LOG_DEBUG);
+	CHECK_EQ(log.getLevel(LOG_WIFI), LOG_DEBUG);
+
+	//formatting
+	hostSetMillis(12345);
+	log.add(LOG_HTTP, LOG_WARN, "Busy (%u in flight), rejected %s", 7, 0, "/index.html");
+	CHECK(log.format(0, line, sizeof(line)) > 0);
+	CHECK(strcmp(line, "[12.345] http warn: Busy (7 in flight), rejected /index.html\n") == 0);
+	log.add(LOG_FS, LOG_ERROR, "%d %x%%", (uint32_t)-5, 255);
+	log.format(1, line, sizeof(line));
+	CHECK(strcmp(line, "[12.345] fs error: -5 ff%\n") == 0);
+
+	//string argument is copied and cut
+	char name[40];
+	strcpy(name, "a-rather-long-access-point-name");
+	log.add(LOG_WIFI, LOG_INFO, "Connecting to %s", 0, 0, name);
+	name[0] = 'X';
+	log.format(2, line, sizeof(line));
+	char expected[64];
+	snprintf(expected, sizeof(expected), "[12.345] wifi info: Connecting to %.*s\n", EVENTLOG_STR_LEN - 1, "a-rather-long-access-point-name");
+	CHECK(strcmp(line, expected) == 0);
+
+	//small buffers are cut but stay terminated lines
+	char small[16];
+	size_t len = log.format(0, small, sizeof(small));
+	CHECK_EQ(len, strlen(small));
+	CHECK(len < sizeof(small));
+	CHECK_EQ(small[len - 1], '\n');
+
+	//wrap-around: the oldest entries are overwritten
+	for (uint32_t i = 0; i < 2 * EVENTLOG_ENTRIES; i++) log.add(LOG_UPDATE, LOG_INFO, "entry %u", i);
+	CHECK_EQ(log.next(), 3 + 2 * EVENTLOG_ENTRIES);
+	CHECK_EQ(log.first(), log.next() - EVENTLOG_ENTRIES);
+	CHECK_EQ(log.format(0, line, sizeof(line)), 0);
+	CHECK_EQ(log.format(log.first() - 1, line, sizeof(line)), 0);
+	CHECK_EQ(log.format(log.next(), line, sizeof(line)), 0);
+	log.format(log.first(), line, sizeof(line));
+	snprintf(expected, sizeof(expected), "[12.345] update info: entry %u\n", EVENTLOG_ENTRIES);
+	CHECK(strcmp(line, expected) == 0);
+	log.format(log.next() - 1, line, sizeof(line));
+	snprintf(expected, sizeof(expected), "[12.345] update info: entry %u\n", 2 * EVENTLOG_ENTRIES - 1);
+	CHECK(strcmp(line, expected) == 0);
+
+	//names
+	CHECK_EQ(EventLog::parseSubsystem(String("update")), LOG_UPDATE);
+	CHECK_EQ(EventLog::parseSubsystem(String("nope")), -1);
+	CHECK_EQ(EventLog::parseLevel(String("debug")), LOG_DEBUG);
+	CHECK_EQ(EventLog::parseLevel(String("")), -1);
+	CHECK(strcmp(EventLog::subsystemName(LOG_FS), "fs") == 0);
+	CHECK(strcmp(EventLog::subsystemName(LOG_SUBSYSTEMS), "") == 0);
+
+	return TEST_RESULT();
+}
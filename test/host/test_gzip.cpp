@@ -0,0 +1,109 @@
+// GzipWriter: every output must inflate back to the input with zlib
+
+#include "GzipWriter.h"
+#include "test.h"
+#include <zlib.h>
+#include <string>
+#include <vector>
+
+class VectorPrint : public Print {
+public:
+	std::vector<uint8_t> data;
+	size_t failAfter = (size_t)-1; // simulates a full filesystem
+	virtual size_t write(uint8_t c) override { return write(&c, 1); }
+	virtual size_t write(const uint8_t* buf, size_t len) override {
+		if (data.size() + len > failAfter) return 0;
+		data.insert(data.end(), buf, buf + len);
+		return len;
+	}
+};
+
+static std::string gunzip(const std::vector<uint8_t>& in) {
+	std::string out;
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK) return "<init failed>";
+	zs.next_in = (Bytef*)in.data();
+	zs.avail_in = in.size();
+	char buf[4096];
+	int ret;
+	do {
+		zs.next_out = (Bytef*)buf;
+		zs.avail_out = sizeof(buf);
+		ret = inflate(&zs, Z_NO_FLUSH);
+		out.append(buf, sizeof(buf) - zs.avail_out);
+	} while (ret == Z_OK);
+	inflateEnd(&zs);
+	return (ret == Z_STREAM_END) ? out : "<inflate failed>";
+}
+
+static void roundTrip(const std::string& input, size_t chunk) {
+	VectorPrint sink;
+	GzipWriter gz(sink);
+	for (size_t pos = 0; pos < input.size(); pos += chunk) {
+		size_t n = std::min(chunk, input.size() - pos);
+		CHECK_EQ(gz.write((const uint8_t*)input.data() + pos, n), n);
+	}
+	CHECK(gz.finish());
+	CHECK_EQ(gz.inputSize(), input.size());
+	CHECK_EQ(gz.outputSize(), sink.data.size());
+	CHECK(gunzip(sink.data) == input);
+}
+
+static std::string htmlPage(size_t size) {
+	std::string s;
+	for (int i = 0; s.size() < size; i++) {
+		s += "<div class=\"row\"><label for=\"field" + std::to_string(i % 37) + "\">Field</label>";
+		s += "<input id=\"field" + std::to_string(i) + "\" type=\"text\" value=\"\"></div>\n";
+	}
+	s.resize(size);
+	return s;
+}
+
+static std::string randomBytes(size_t size) {
+	std::string s;
+	uint32_t x = 0x12345678;
+	for (size_t i = 0; i < size; i++) {
+		x = x * 1103515245 + 12345;
+		s += (char)(x >> 23);
+	}
+	return s;
+}
+
+int main() {
+	const size_t chunks[] = { 1, 7, 100, 1460, 100000 };
+	std::vector<std::string> inputs;
+	inputs.push_back("");
+	inputs.push_back("a");
+	inputs.push_back("abcabcabcabcabcabcabcabc");
+	inputs.push_back(std::string(5000, 'x')); // matches longer than the 258 byte maximum
+	inputs.push_back(htmlPage(20000)); // slides the window many times
+	inputs.push_back(randomBytes(9000)); // literals only
+	for (size_t i = 0; i < inputs.size(); i++) {
+		for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) roundTrip(inputs[i], chunks[c]);
+	}
+
+	//text must actually get smaller
+	VectorPrint sink;
+	GzipWriter gz(sink);
+	std::string page = htmlPage(20000);
+	gz.write((const uint8_t*)page.data(), page.size());
+	gz.finish();
+	CHECK(sink.data.size() < page.size() / 3);
+
+	//a failing output is reported, not hidden
+	VectorPrint full;
+	full.failAfter = 100;
+	GzipWriter gzFull(full);
+	std::string noise = randomBytes(5000);
+	gzFull.write((const uint8_t*)noise.data(), noise.size());
+	CHECK(!gzFull.finish());
+
+	//crc32Update matches zlib, also when fed in pieces
+	std::string text = htmlPage(3000);
+	uint32_t crc = crc32Update(0, (const uint8_t*)text.data(), 1000);
+	crc = crc32Update(crc, (const uint8_t*)text.data() + 1000, text.size() - 1000);
+	CHECK_EQ(crc, crc32(0, (const Bytef*)text.data(), text.size()));
+
+	return TEST_RESULT();
+}
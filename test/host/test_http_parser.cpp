@@ -0,0 +1,165 @@
+// HTTPResponseParser: results must not depend on how the response is split into segments
+
+#include "HTTPResponseParser.h"
+#include "test.h"
+#include <string>
+#include <vector>
+
+typedef struct {
+	int status;
+	std::string headers; // "name=value;" for every header
+	std::string body;
+	bool headersDone;
+	bool parseOkay;
+	enumHTTPParseState state;
+	enumHTTPParseError error;
+	int32_t contentLength;
+} strResult;
+
+static void attach(HTTPResponseParser& parser, strResult& r) {
+	r.status = 0;
+	r.headers = "";
+	r.body = "";
+	r.headersDone = false;
+	parser.onHeader([&r](const char* name, size_t nameLen, const char* value, size_t valueLen) {
+		r.headers.append(name, nameLen);
+		r.headers += "=";
+		r.headers.append(value, valueLen);
+		r.headers += ";";
+	});
+	parser.onHeadersComplete([&r](int statusCode) {
+		r.status = statusCode;
+		r.headersDone = true;
+		return true;
+	});
+	parser.onBody([&r](const uint8_t* data, size_t len) {
+		r.body.append((const char*)data, len);
+		return true;
+	});
+}
+
+// parses the response in the given pieces
+static strResult parseSplit(const std::string& response, const std::vector<size_t>& cuts) {
+	HTTPResponseParser parser;
+	strResult r;
+	attach(parser, r);
+	r.parseOkay = true;
+	size_t pos = 0;
+	for (size_t i = 0; i <= cuts.size() && r.parseOkay; i++) {
+		size_t end = (i < cuts.size()) ? cuts[i] : response.size();
+		r.parseOkay = parser.parse((const uint8_t*)response.data() + pos, end - pos);
+		pos = end;
+	}
+	r.state = parser.state();
+	r.error = parser.error();
+	r.contentLength = parser.contentLength();
+	return r;
+}
+
+static void checkEverySplit(const std::string& response, const strResult& expected) {
+	//one cut at every position
+	for (size_t cut = 0; cut <= response.size(); cut++) {
+		strResult r = parseSplit(response, std::vector<size_t>(1, cut));
+		CHECK(r.parseOkay == expected.parseOkay);
+		CHECK_EQ(r.status, expected.status);
+		CHECK(r.headers == expected.headers);
+		CHECK(r.body == expected.body);
+		CHECK_EQ(r.state, expected.state);
+		CHECK_EQ(r.error, expected.error);
+	}
+	//one byte per segment
+	std::vector<size_t> cuts;
+	for (size_t i = 1; i < response.size(); i++) cuts.push_back(i);
+	strResult r = parseSplit(response, cuts);
+	CHECK(r.headers == expected.headers);
+	CHECK(r.body == expected.body);
+	CHECK_EQ(r.state, expected.state);
+	CHECK_EQ(r.error, expected.error);
+}
+
+int main() {
+	//Content-Length body
+	std::string plain = "HTTP/1.1 200 OK\r\nContent-Length: 11\r\nx-version: 1.2.3\r\n\r\nhello world";
+	strResult r = parseSplit(plain, std::vector<size_t>());
+	CHECK(r.parseOkay);
+	CHECK_EQ(r.status, 200);
+	CHECK(r.headers == "Content-Length=11;x-version=1.2.3;");
+	CHECK(r.body == "hello world");
+	CHECK_EQ(r.state, HTTP_PARSE_DONE);
+	CHECK_EQ(r.contentLength, 11);
+	checkEverySplit(plain, r);
+
+	//chunked body with extension and trailer
+	std::string chunked = "HTTP/1.1 206 Partial Content\r\nTransfer-Encoding: chunked\r\n\r\n"
+		"5;ext=1\r\nhello\r\nA\r\n, chunked!\r\n0\r\nX-Trailer: 1\r\n\r\n";
+	r = parseSplit(chunked, std::vector<size_t>());
+	CHECK(r.parseOkay);
+	CHECK_EQ(r.status, 206);
+	CHECK(r.body == "hello, chunked!");
+	CHECK_EQ(r.state, HTTP_PARSE_DONE);
+	checkEverySplit(chunked, r);
+
+	//headers only, no body
+	std::string empty = "HTTP/1.0 304 Not Modified\nContent-Length: 0\n\n";
+	r = parseSplit(empty, std::vector<size_t>());
+	CHECK_EQ(r.status, 304);
+	CHECK_EQ(r.state, HTTP_PARSE_DONE);
+	checkEverySplit(empty, r);
+
+	//errors
+	r = parseSplit("FTP/1.1 200 OK\r\n\r\n", std::vector<size_t>());
+	CHECK(!r.parseOkay);
+	CHECK_EQ(r.error, HTTP_PARSE_ERROR_RESPONSE);
+	r = parseSplit("HTTP/1.1 200 OK\r\nno colon here\r\n\r\n", std::vector<size_t>());
+	CHECK_EQ(r.error, HTTP_PARSE_ERROR_HEADER);
+	r = parseSplit("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", std::vector<size_t>());
+	CHECK_EQ(r.error, HTTP_PARSE_ERROR_CHUNK);
+
+	//overlong header lines are skipped, whole or split
+	std::string cookie = "HTTP/1.1 200 OK\r\nSet-Cookie: session=" + std::string(300, 'c') + "; Path=/; HttpOnly\r\n"
+		"x-MD5: 0123\r\nContent-Length: 2\r\n\r\nok";
+	r = parseSplit(cookie, std::vector<size_t>());
+	CHECK(r.parseOkay);
+	CHECK_EQ(r.status, 200);
+	CHECK(r.headers == "x-MD5=0123;Content-Length=2;");
+	CHECK(r.body == "ok");
+	CHECK_EQ(r.state, HTTP_PARSE_DONE);
+	checkEverySplit(cookie, r);
+	std::string maxLine = "HTTP/1.1 200 OK\r\nX: " + std::string(HTTP_PARSER_LINE_MAX - 5, 'a') + "\r\nContent-Length: 0\r\n\r\n";
+	r = parseSplit(maxLine, std::vector<size_t>());
+	CHECK(r.parseOkay);
+	CHECK(r.headers == "X=" + std::string(HTTP_PARSER_LINE_MAX - 5, 'a') + ";Content-Length=0;");
+	CHECK_EQ(r.state, HTTP_PARSE_DONE);
+	checkEverySplit(maxLine, r);
+
+	//status and chunk size lines keep the hard limit
+	std::string longStatus = "HTTP/1.1 200 " + std::string(HTTP_PARSER_LINE_MAX, 'O') + "\r\n\r\n";
+	r = parseSplit(longStatus, std::vector<size_t>());
+	CHECK(!r.parseOkay);
+	CHECK_EQ(r.error, HTTP_PARSE_ERROR_LINE_TOO_LONG);
+	checkEverySplit(longStatus, r);
+	std::string longChunk = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n1;" + std::string(HTTP_PARSER_LINE_MAX, 'e') + "\r\na\r\n0\r\n\r\n";
+	r = parseSplit(longChunk, std::vector<size_t>());
+	CHECK(!r.parseOkay);
+	CHECK_EQ(r.error, HTTP_PARSE_ERROR_LINE_TOO_LONG);
+	checkEverySplit(longChunk, r);
+
+	//a callback can stop the transfer
+	HTTPResponseParser parser;
+	parser.onHeadersComplete([](int statusCode) { return statusCode == 200; });
+	std::string notFound = "HTTP/1.1 404 Not Found\r\nContent-Length: 3\r\n\r\nabc";
+	CHECK(!parser.parse((const uint8_t*)notFound.data(), notFound.size()));
+	CHECK_EQ(parser.error(), HTTP_PARSE_ERROR_ABORTED);
+	parser.reset();
+	CHECK_EQ(parser.state(), HTTP_PARSE_STATUS);
+
+	//helpers
+	CHECK(HTTPResponseParser::headerIs("content-length", 14, "Content-Length"));
+	CHECK(!HTTPResponseParser::headerIs("Content-Len", 11, "Content-Length"));
+	CHECK_EQ(HTTPResponseParser::toUInt("1234x", 5), 1234);
+	String s;
+	HTTPResponseParser::assign(s, "value", 3);
+	CHECK(s == "val");
+
+	return TEST_RESULT();
+}
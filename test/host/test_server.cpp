@@ -0,0 +1,160 @@
+// Requests through the whole server: handler order, routes, onNotFound and handleFileRead()
+
+#include "test.h"
+#include "host_server.h"
+
+static HostServer server;
+static fs::FS flash;
+
+static const char* indexHtml = "<html><body>index</body></html>";
+static const char* styleGz = "\x1f\x8b\x08\x00gzipped css";
+
+static void testDispatch() {
+	//registered route
+	{
+		HostRequest r(server, HTTP_GET, "/all");
+		r.run();
+		CHECK_EQ(r.status(), 200);
+		CHECK(r.body().find("\"heap\"") != std::string::npos);
+	}
+	//route with another method => onNotFound => no such file
+	uint32_t notFound = server._metricsNotFound;
+	{
+		HostRequest r(server, HTTP_POST, "/all");
+		r.run();
+		CHECK_EQ(r.status(), 404);
+	}
+	CHECK_EQ(server._metricsNotFound, notFound + 1);
+	//no route => onNotFound serves the file
+	{
+		HostRequest r(server, HTTP_GET, "/index.html");
+		r.run();
+		CHECK_EQ(r.status(), 200);
+		CHECK(r.body() == indexHtml);
+	}
+	//the matched route is kept from canHandle() until handleRequest()
+	{
+		HostRequest a(server, HTTP_GET, "/all");
+		HostRequest b(server, HTTP_GET, "/list");
+		b.param("dir", "/");
+		a.attach();
+		b.attach();
+		b.handle();
+		a.handle();
+		CHECK_EQ(a.status(), 200);
+		CHECK_EQ(b.status(), 200);
+		CHECK(b.body().find("\"index.html\"") != std::string::npos);
+	}
+}
+
+static void testPrefixRoutes() {
+	String restUrl;
+	server.setRESTCallback([&restUrl](AsyncWebServerRequest *request) {
+		restUrl = request->url();
+		request->send(200, "text/plain", "rest");
+	});
+	server.setJSONCallback([](AsyncWebServerRequest *request) { request->send(200, "text/json", "{}"); });
+	//the callback gets the whole URL, like from the on("/rest") handler before
+	{
+		HostRequest r(server, HTTP_GET, "/rest/x");
+		r.run();
+		CHECK_EQ(r.status(), 200);
+		CHECK(restUrl == "/rest/x");
+	}
+	{
+		HostRequest r(server, HTTP_POST, "/rest/led/1");
+		r.run();
+		CHECK_EQ(r.status(), 200);
+		CHECK(restUrl == "/rest/led/1");
+	}
+	{
+		HostRequest r(server, HTTP_GET, "/json/a");
+		r.run();
+		CHECK_EQ(r.status(), 200);
+		CHECK(r.body() == "{}");
+	}
+	//exact routes stay exact, a longer first segment is another path
+	{
+		HostRequest r(server, HTTP_GET, "/all/x");
+		r.run();
+		CHECK_EQ(r.status(), 404);
+	}
+	{
+		HostRequest r(server, HTTP_GET, "/restx");
+		r.run();
+		CHECK_EQ(r.status(), 404);
+	}
+	//a full match wins over the prefix
+	{
+		HostRequest r(server, HTTP_GET, "/admin/values/info");
+		r.run();
+		CHECK(server.findRoute(r.request) && !strcmp(server.findRoute(r.request)->path, "/admin/values/info"));
+	}
+}
+
+static void testFileRead() {
+	String etag;
+	{
+		HostRequest r(server, HTTP_GET, "/");
+		r.run();
+		CHECK_EQ(r.status(), 200);
+		CHECK(r.body() == indexHtml);
+		CHECK(r.responseHeader("Cache-Control") == "no-cache");
+		CHECK(r.responseHeader("Content-Encoding") == "");
+		etag = r.responseHeader("ETag");
+		CHECK(etag.length() > 2);
+	}
+	//revalidation: one open of the indexed variant
+	{
+		HostRequest r(server, HTTP_GET, "/index.html");
+		r.header("If-None-Match", etag);
+		uint32_t opens = flash.hostOpens;
+		r.run();
+		CHECK_EQ(r.status(), 304);
+		CHECK_EQ(flash.hostOpens - opens, 1);
+		CHECK(r.responseHeader("ETag") == etag);
+		CHECK(r.body().empty());
+	}
+	//only the .gz variant exists
+	{
+		HostRequest r(server, HTTP_GET, "/style.css");
+		r.run();
+		CHECK_EQ(r.status(), 200);
+		CHECK(r.body() == styleGz);
+		CHECK(r.responseHeader("Content-Encoding") == "gzip");
+		CHECK(r.request->hostResponse()->hostHeaderCount("Content-Encoding") == 1);
+		CHECK(r.request->hostResponse()->hostContentType() == "text/css");
+	}
+	//changed behind the index => the old ETag no longer matches
+	flash.hostWrite("/index.html", "<html>new</html>", 1600000000);
+	{
+		HostRequest r(server, HTTP_GET, "/index.html");
+		r.header("If-None-Match", etag);
+		r.run();
+		CHECK_EQ(r.status(), 200);
+		CHECK(r.body() == "<html>new</html>");
+		CHECK(r.responseHeader("ETag") != etag);
+	}
+	//removed behind the index
+	flash.remove("/index.html");
+	{
+		HostRequest r(server, HTTP_GET, "/index.html");
+		r.run();
+		CHECK_EQ(r.status(), 404);
+	}
+	{
+		HostRequest r(server, HTTP_GET, "/missing.txt");
+		r.run();
+		CHECK_EQ(r.status(), 404);
+	}
+}
+
+int main() {
+	flash.hostWrite("/index.html", indexHtml, 1500000000);
+	flash.hostWrite("/style.css.gz", std::string(styleGz, strlen(styleGz)), 1500000000);
+	server.begin(&flash);
+	testDispatch();
+	testPrefixRoutes();
+	testFileRead();
+	return TEST_RESULT();
+}
@@ -0,0 +1,87 @@
+// SlabPool: blocks come from the pools while they last, everything else from the heap
+
+#include "SlabPool.h"
+#include "test.h"
+#include <vector>
+
+static uint8_t totalUsed() {
+	uint8_t used = 0;
+	for (uint8_t i = 0; i < SLAB_POOLS; i++) used += slabStats(i).used;
+	return used;
+}
+
+int main() {
+	//before slabBegin() everything comes from malloc
+	void* early = slabAlloc(100);
+	CHECK(early != NULL);
+	CHECK_EQ(slabStats(0).fallbacks, 1);
+	slabFree(early);
+
+	CHECK(slabBegin());
+	CHECK(slabBegin()); // second call keeps the arenas
+	CHECK_EQ(slabStats(0).blockSize, SLAB_SMALL_SIZE);
+	CHECK_EQ(slabStats(1).blockSize, SLAB_MEDIUM_SIZE);
+	CHECK_EQ(slabStats(2).blockSize, SLAB_LARGE_SIZE);
+
+	//smallest fitting class first, then the larger ones, then the heap
+	const int blocks = SLAB_SMALL_COUNT + SLAB_MEDIUM_COUNT + SLAB_LARGE_COUNT;
+	std::vector<void*> p;
+	size_t capacity = 0;
+	for (int i = 0; i < blocks + 2; i++) {
+		p.push_back(slabAlloc(200, &capacity));
+		CHECK(p.back() != NULL);
+		memset(p.back(), i, 200);
+		if (i < SLAB_SMALL_COUNT) CHECK_EQ(capacity, SLAB_SMALL_SIZE);
+		else if (i < SLAB_SMALL_COUNT + SLAB_MEDIUM_COUNT) CHECK_EQ(capacity, SLAB_MEDIUM_SIZE);
+		else if (i < blocks) CHECK_EQ(capacity, SLAB_LARGE_SIZE);
+		else CHECK_EQ(capacity, 200);
+	}
+	CHECK_EQ(slabStats(0).used, SLAB_SMALL_COUNT);
+	CHECK_EQ(slabStats(0).fallbacks, 1 + 2);
+	for (int i = 0; i < blocks + 2; i++) {
+		CHECK_EQ(((uint8_t*)p[i])[199], i); // no overlapping blocks
+		slabFree(p[i]);
+	}
+	CHECK_EQ(totalUsed(), 0);
+	CHECK_EQ(slabStats(0).peak, SLAB_SMALL_COUNT);
+	CHECK_EQ(slabStats(2).peak, SLAB_LARGE_COUNT);
+
+	//freed blocks are handed out again
+	void* a = slabAlloc(10);
+	slabFree(a);
+	void* b = slabAlloc(10);
+	CHECK(a == b);
+	slabFree(b);
+	slabFree(NULL);
+
+	//too large for every class
+	void* big = slabAlloc(SLAB_LARGE_SIZE + 1, &capacity);
+	CHECK(big != NULL);
+	CHECK_EQ(capacity, SLAB_LARGE_SIZE + 1);
+	CHECK_EQ(totalUsed(), 0);
+	slabFree(big);
+
+	//PooledBuffer grows through the classes into the heap and keeps its content
+	{
+		PooledBuffer buf(16);
+		CHECK_EQ(slabStats(0).used, 1);
+		for (int i = 0; i < 5000; i++) buf.print((char)('a' + i % 26));
+		CHECK_EQ(buf.length(), 5000);
+		bool same = true;
+		for (int i = 0; i < 5000; i++) same &= (buf.data()[i] == 'a' + i % 26);
+		CHECK(same);
+		CHECK_EQ(strlen(buf.c_str()), 5000);
+		CHECK_EQ(totalUsed(), 0); // all blocks given back while growing
+	}
+	{
+		PooledBuffer buf;
+		CHECK(strcmp(buf.c_str(), "") == 0);
+		buf.printf("%s=%d", "value", 42);
+		CHECK(strcmp(buf.c_str(), "value=42") == 0);
+		CHECK_EQ(buf.length(), 8);
+		CHECK_EQ(slabStats(0).used, 1);
+	}
+	CHECK_EQ(totalUsed(), 0);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,73 @@
+// A day of mixed traffic, several requests overlapping: slab blocks, admission
+// slots and heap in use must come back to the same level after every burst
+
+#include "test.h"
+#include "host_server.h"
+#include <malloc.h>
+
+static HostServer server;
+static fs::FS flash;
+
+static const char* const urls[] = {
+	"/", "/admin.html", "/style.css", "/all", "/list", "/metrics", "/admin/log",
+	"/admin/values/network", "/admin/values/info", "/admin/values/ntp", "/admin/values/connectionstate",
+	"/admin/actions/scan", "/missing.png"
+};
+static const size_t urlCount = sizeof(urls) / sizeof(urls[0]);
+
+static void checkIdle() {
+	for (uint8_t i = 0; i < SLAB_POOLS; i++) CHECK_EQ(slabStats(i).used, 0);
+	CHECK_EQ(server._admitted.size(), 0);
+}
+
+// up to 4 requests overlapping like the browser fetching a page
+static void burst(uint32_t step, String& etag) {
+	HostRequest* r[4];
+	uint8_t n = 1 + step % 4;
+	for (uint8_t i = 0; i < n; i++) {
+		const char* url = urls[(step * 5 + i * 3) % urlCount];
+		r[i] = new HostRequest(server, HTTP_GET, url);
+		if (!strcmp(url, "/list")) r[i]->param("dir", "/");
+		if (!strcmp(url, "/") && (step & 1) && etag.length()) r[i]->header("If-None-Match", etag);
+		r[i]->attach();
+	}
+	for (uint8_t i = 0; i < n; i++) {
+		r[i]->handle();
+		//the bodies are sent while the other requests are still open
+		std::string body = r[i]->body();
+		CHECK(r[i]->status() != 0);
+		if (r[i]->status() == 503) CHECK(false);
+		if (!strcmp(r[i]->request->url().c_str(), "/") && (r[i]->status() == 200)) etag = r[i]->responseHeader("ETag");
+	}
+	for (uint8_t i = 0; i < n; i++) delete r[i];
+	server.handle();
+}
+
+int main() {
+	std::string page;
+	while (page.size() < 6000) page += "<div class=\"row\"><label>Field</label><input type=\"text\"></div>\n";
+	flash.hostWrite("/index.html", page, 1500000000);
+	flash.hostWrite("/admin.html", page.substr(0, 3000), 1500000000);
+	flash.hostWrite("/style.css.gz", std::string(1200, 'c'), 1500000000);
+	server.begin(&flash);
+
+	String etag;
+	size_t heapAfterHour = 0;
+	const uint32_t stepSeconds = 5;
+	for (uint32_t step = 0; step < 24 * 3600 / stepSeconds; step++) {
+		hostSetMillis(step * stepSeconds * 1000);
+		burst(step, etag);
+		checkIdle();
+		if (step == 3600 / stepSeconds) heapAfterHour = mallinfo2().uordblks;
+		if (testFailures) break;
+	}
+	size_t heapAfterDay = mallinfo2().uordblks;
+	//the event log and the caches are full after the first hour, nothing may grow after that
+	printf("heap in use after 1 h: %u bytes, after 24 h: %u bytes\n", (unsigned)heapAfterHour, (unsigned)heapAfterDay);
+	CHECK(heapAfterDay <= heapAfterHour);
+	for (uint8_t i = 0; i < SLAB_POOLS; i++) {
+		const strSlabStats& stats = slabStats(i);
+		printf("slab %4u B: peak %u of %u, %u allocs, %u fallbacks\n", stats.blockSize, stats.peak, stats.blocks, stats.allocs, stats.fallbacks);
+	}
+	return TEST_RESULT();
+}
@@ -0,0 +1,41 @@
+// OTA download through the staging buffers: back-pressure, integrity, completion
+
+#include "test.h"
+#include "host_server.h"
+
+static HostServer server;
+static fs::FS flash;
+
+static std::string makeImage(size_t size) {
+	std::string image(size, 0);
+	for (size_t i = 0; i < size; i++) image[i] = (char)(i * 31 + (i >> 8));
+	return image;
+}
+
+static void testDownload(size_t size, size_t segmentsPerLoop) {
+	std::string image = makeImage(size);
+	server.updateFirmware(false);
+	CHECK(server._asyncClient && server._asyncClient->hostConnecting);
+	CHECK(hostServeFirmware(server, image, segmentsPerLoop));
+	AsyncClient* c = server._asyncClient;
+	CHECK(c->hostSent.compare(0, 4, "GET ") == 0);
+	CHECK_EQ(Update.hostCommand, U_FLASH);
+	CHECK_EQ(Update.hostWritten, size);
+	CHECK(Update.hostFinished);
+	//everything acked, also the last segment of each onData
+	CHECK_EQ(c->hostAcked, c->hostReceived);
+	CHECK_EQ(server._firmware.state, FW_IDLE);
+	CHECK_EQ(server._firmware.lastError, FW_ERROR_NONE);
+	CHECK(!server._fwStage.buf[0]);
+}
+
+int main() {
+	server.begin(&flash);
+	server._firmware.server = "fw.local";
+	//handle() after every segment, and a loop() too slow to keep up
+	testDownload(100000, 1);
+	testDownload(65536, 8);
+	//less than one sector
+	testDownload(1000, 1);
+	return TEST_RESULT();
+}
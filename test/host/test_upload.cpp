@@ -0,0 +1,90 @@
+// Parallel /edit uploads: each keeps its own state, the slot limit answers 503
+
+#include "test.h"
+#include "host_server.h"
+
+static HostServer server;
+static fs::FS flash;
+
+static std::string makeBody(size_t size, char seed) {
+	std::string body(size, 0);
+	for (size_t i = 0; i < size; i++) body[i] = (char)(seed + i * 7 + (i >> 9));
+	return body;
+}
+
+// the file parts as the multipart parser hands them over
+static void sendPart(HostRequest& r, const char* filename, const std::string& body, size_t index, size_t len) {
+	r.request->hostHandler()->handleUpload(r.request, filename, index, (uint8_t*)body.data() + index, len, index + len == body.size());
+}
+
+static HostRequest* startUpload(const char* filename, size_t size) {
+	HostRequest* r = new HostRequest(server, HTTP_POST, "/edit");
+	r->request->hostParam("data", filename, true, true, size);
+	r->request->hostContentLength(size + 200);
+	r->attach();
+	return r;
+}
+
+static void testParallel() {
+	const size_t chunk = 1460;
+	std::string a = makeBody(20000, 'a');
+	std::string b = makeBody(7000, 'b');
+	std::string c = makeBody(3000, 'c');
+	HostRequest* ra = startUpload("/a.bin", a.size());
+	HostRequest* rb = startUpload("/b.bin", b.size());
+	HostRequest* rc = startUpload("/c.bin", c.size());
+	uint32_t start = micros();
+	//all three interleaved segment by segment, the third finds no slot
+	for (size_t index = 0; index < a.size(); index += chunk) {
+		sendPart(*ra, "/a.bin", a, index, std::min(chunk, a.size() - index));
+		if (index < b.size()) sendPart(*rb, "/b.bin", b, index, std::min(chunk, b.size() - index));
+		if (index < c.size()) sendPart(*rc, "/c.bin", c, index, std::min(chunk, c.size() - index));
+	}
+	uint32_t us = micros() - start;
+	rb->handle();
+	ra->handle();
+	rc->handle();
+	CHECK_EQ(ra->status(), 200);
+	CHECK_EQ(rb->status(), 200);
+	CHECK_EQ(rc->status(), 503);
+	CHECK(flash.hostRead("/a.bin") == a);
+	CHECK(flash.hostRead("/b.bin") == b);
+	CHECK(!flash.exists("/c.bin"));
+	printf("2 parallel uploads, %u bytes in %u us (%.1f MB/s)\n", (unsigned)(a.size() + b.size()), us, us ? (a.size() + b.size()) / (double)us : 0.0);
+	delete ra;
+	delete rb;
+	delete rc;
+	for (uint8_t i = 0; i < UPLOAD_MAX_CONCURRENT; i++) CHECK(!server._uploads[i].request);
+}
+
+static void testNoSpace() {
+	flash.hostTotalBytes = 40000;
+	std::string body = makeBody(50000, 'x');
+	HostRequest* r = startUpload("/big.bin", body.size());
+	sendPart(*r, "/big.bin", body, 0, 1460);
+	r->handle();
+	CHECK_EQ(r->status(), 507);
+	CHECK(!flash.exists("/big.bin"));
+	delete r;
+	flash.hostTotalBytes = 1024 * 1024;
+}
+
+// the connection goes away mid-upload => partial file removed, slot free again
+static void testInterrupted() {
+	std::string body = makeBody(10000, 'i');
+	HostRequest* r = startUpload("/cut.bin", body.size());
+	sendPart(*r, "/cut.bin", body, 0, 4000);
+	CHECK(server._uploads[0].request || server._uploads[1].request);
+	delete r;
+	server.handle();
+	CHECK(!server._uploads[0].request && !server._uploads[1].request);
+	CHECK(!flash.exists("/cut.bin"));
+}
+
+int main() {
+	server.begin(&flash);
+	testParallel();
+	testNoSpace();
+	testInterrupted();
+	return TEST_RESULT();
+}
@@ -0,0 +1,47 @@
+// URI codec kernels
+
+#include "URICodec.h"
+#include "test.h"
+#include <string>
+
+static std::string encode(const std::string& in) {
+	std::string out(uriEncodedLength(in.data(), in.size()), '\0');
+	out.resize(uriEncode(in.data(), in.size(), &out[0]));
+	return out;
+}
+
+static std::string decode(const std::string& in) {
+	std::string out(in.size(), '\0');
+	out.resize(uriDecode(in.data(), in.size(), &out[0]));
+	return out;
+}
+
+int main() {
+	CHECK(encode("") == "");
+	CHECK(encode("Az09-_.!~*'()") == "Az09-_.!~*'()");
+	CHECK(encode("a b&c=d/e") == "a%20b%26c%3Dd%2Fe");
+	CHECK(encode("\xC3\xA4") == "%C3%A4");
+
+	CHECK(decode("a%20b+c") == "a b c");
+	CHECK(decode("%41%4a%4A") == "AJJ");
+	//invalid or cut escapes stay as they are
+	CHECK(decode("100%") == "100%");
+	CHECK(decode("%4") == "%4");
+	CHECK(decode("%zz%4g") == "%zz%4g");
+
+	//every byte survives a round trip, encoded output only uses unreserved characters and escapes
+	std::string all;
+	for (int c = 0; c < 256; c++) all += (char)c;
+	std::string encoded = encode(all);
+	CHECK_EQ(encoded.size(), uriEncodedLength(all.data(), all.size()));
+	CHECK(encoded.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_.!~*'()%") == std::string::npos);
+	CHECK(decode(encoded) == all);
+
+	//decoding in place
+	char buf[] = "x%2By%20z";
+	size_t len = uriDecode(buf, strlen(buf), buf);
+	CHECK_EQ(len, 5);
+	CHECK(std::string(buf, len) == "x+y z");
+
+	return TEST_RESULT();
+}